@@ -0,0 +1,65 @@
+//==============================================================================
+// AttributeCache.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "AttributeCache.h"
+
+//==============================================================================
+// Recherche d'une valeur : l'enregistrement du feature devient le plus recent
+//==============================================================================
+bool AttributeCache::Find(GIntBig id, int field, std::string& value)
+{
+	auto iter = m_Map.find(id);
+	if (iter == m_Map.end())
+		return false;
+	Record& record = iter->second->second;
+	if ((field < 0) || (field >= (int)record.Loaded.size()) || (!record.Loaded[field]))
+		return false;
+	m_List.splice(m_List.begin(), m_List, iter->second);
+	value = record.Value[field];
+	return true;
+}
+
+//==============================================================================
+// Ajout d'une valeur, en retirant les features les plus anciens si besoin
+//==============================================================================
+void AttributeCache::Insert(GIntBig id, int nbField, int field, const std::string& value)
+{
+	if ((id == OGRNullFID) || (field < 0) || (field >= nbField))
+		return;
+	auto iter = m_Map.find(id);
+	if (iter == m_Map.end()) {
+		m_List.emplace_front(id, Record());
+		m_List.front().second.Value.resize(nbField);
+		m_List.front().second.Loaded.resize(nbField, false);
+		m_Map[id] = m_List.begin();
+		m_nSize += nbField * sizeof(std::string);
+	}
+	else
+		m_List.splice(m_List.begin(), m_List, iter->second);
+	Record& record = m_List.front().second;
+	if ((field >= (int)record.Loaded.size()) || (record.Loaded[field]))
+		return;
+	record.Value[field] = value;
+	record.Loaded[field] = true;
+	m_nSize += value.size();
+	Evict();
+}
+
+//==============================================================================
+// Liberation des features les plus anciens ; le plus recent est conserve
+//==============================================================================
+void AttributeCache::Evict()
+{
+	while ((m_nSize > m_nBudget) && (m_List.size() > 1)) {
+		Record& record = m_List.back().second;
+		m_nSize -= record.Value.size() * sizeof(std::string);
+		for (size_t i = 0; i < record.Value.size(); i++)
+			m_nSize -= record.Value[i].size();
+		m_Map.erase(m_List.back().first);
+		m_List.pop_back();
+	}
+}
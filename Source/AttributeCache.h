@@ -0,0 +1,44 @@
+//==============================================================================
+// AttributeCache.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ogrsf_frmts.h"
+
+//==============================================================================
+// AttributeCache : cache LRU des valeurs d'attributs deja decodees, par FID
+// Les champs d'un feature sont lus a la demande : un enregistrement peut n'etre
+// que partiellement rempli
+//==============================================================================
+class AttributeCache {
+public:
+	AttributeCache(size_t budget = 4 * 1024 * 1024) { m_nBudget = budget; m_nSize = 0; }
+
+	void SetBudget(size_t budget) { m_nBudget = budget; Evict(); }
+	size_t Size() const { return m_nSize; }
+
+	bool Find(GIntBig id, int field, std::string& value);
+	void Insert(GIntBig id, int nbField, int field, const std::string& value);
+	void Clear() { m_List.clear(); m_Map.clear(); m_nSize = 0; }
+
+private:
+	typedef struct {
+		std::vector<std::string>	Value;
+		std::vector<bool>					Loaded;
+	} Record;
+	typedef std::list<std::pair<GIntBig, Record> > List;
+	List																		m_List;	// Du plus recent au plus ancien
+	std::unordered_map<GIntBig, List::iterator>	m_Map;
+	size_t																	m_nSize;
+	size_t																	m_nBudget;
+
+	void Evict();
+};
@@ -0,0 +1,148 @@
+//==============================================================================
+// DatasetLoader.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "DatasetLoader.h"
+
+DatasetLoader::DatasetLoader(GeoBase* base) : juce::Thread("DatasetLoader")
+{
+	m_Base = base;
+	m_Type = Vector;
+	m_dProgress = 0.;
+	m_bPending = m_bSuccess = m_bCancelled = false;
+}
+
+DatasetLoader::~DatasetLoader()
+{
+	stopThread(-1);
+}
+
+//==============================================================================
+// Lancement du chargement : renvoie false si un chargement est deja en cours
+//==============================================================================
+bool DatasetLoader::Load(const juce::String& filename, DatasetType type, const juce::String& name)
+{
+	if (IsLoading())
+		return false;
+	m_Loading.Clear();
+	m_Filename = filename;
+	m_Name = name;
+	m_Type = type;
+	m_dProgress = -1.;	// Barre de progression indeterminee tant qu'aucun feature n'est lu
+	m_FeatureText = juce::translate("Features read : ");
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Status = juce::translate("Loading") + " " + filename;
+	}
+	m_bSuccess = m_bCancelled = false;
+	m_bPending = true;
+	startThread();
+	return true;
+}
+
+//==============================================================================
+// Lancement de l'indexation de layers de la base : renvoie false si un chargement
+// est deja en cours
+//==============================================================================
+bool DatasetLoader::IndexLayers(const std::vector<GeoBase::VectorLayer*>& layers)
+{
+	if ((IsLoading()) || (layers.size() < 1))
+		return false;
+	m_Loading.Clear();
+	m_Layers = layers;
+	m_Filename.clear();
+	m_Name.clear();
+	m_Type = Index;
+	m_dProgress = -1.;
+	m_FeatureText = juce::translate("Features read : ");
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Status = juce::translate("Indexing") + " " + juce::String((int)layers.size()) + " " + juce::translate("layer(s)");
+	}
+	m_bSuccess = m_bCancelled = false;
+	m_bPending = true;
+	startThread();
+	return true;
+}
+
+//==============================================================================
+// Ajout du dataset lu a la base, depuis le thread des messages
+// Le thread de dessin doit etre arrete
+//==============================================================================
+bool DatasetLoader::Commit()
+{
+	waitForThreadToExit(-1);	// Le message de fin est envoye juste avant la sortie du thread
+	m_bPending = false;
+	if (m_Type == Index) {	// Les layers sont deja dans la base
+		m_Layers.clear();
+		return (m_bSuccess) && (!m_bCancelled);
+	}
+	if ((!m_bSuccess) || (m_bCancelled) || (m_Base == nullptr)) {
+		m_Loading.Clear();
+		return false;
+	}
+	return m_Base->AddLoading(m_Loading);
+}
+
+juce::String DatasetLoader::Status()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Status;
+}
+
+//==============================================================================
+// Lecture du dataset
+//==============================================================================
+void DatasetLoader::run()
+{
+	if (m_Type == Index)
+		m_bSuccess = GeoBase::IndexLayers(m_Layers, ProgressCallback, this);
+	else if (m_Type == Vector)
+		m_bSuccess = m_Base->LoadVectorDataset(m_Filename.toRawUTF8(), m_Loading, ProgressCallback, this);
+	else if (m_Type == RasterFolder)
+		m_bSuccess = m_Base->LoadRasterFolder(m_Filename.toRawUTF8(), m_Loading, m_Name.toRawUTF8(), ProgressCallback, this);
+	else
+		m_bSuccess = m_Base->LoadRasterDataset(m_Filename.toRawUTF8(), m_Loading, m_Name.toRawUTF8(), true, nullptr, (m_Type == Dtm));
+	m_bCancelled = threadShouldExit();
+	if (m_bCancelled)
+		m_Loading.Clear();
+	m_dProgress = 1.;
+	sendActionMessage("DatasetLoaded");
+}
+
+//==============================================================================
+// Progression GDAL : renvoie FALSE pour interrompre la lecture
+//==============================================================================
+int CPL_STDCALL DatasetLoader::ProgressCallback(double complete, const char* message, void* data)
+{
+	DatasetLoader* loader = (DatasetLoader*)data;
+	if (complete > 0.)
+		loader->m_dProgress = complete;
+	if ((message != nullptr) && (strlen(message) > 0)) {
+		std::lock_guard<std::mutex> lock(loader->m_Mutex);
+		loader->m_Status = loader->m_FeatureText + message;
+	}
+	return loader->threadShouldExit() ? FALSE : TRUE;
+}
+
+//==============================================================================
+// LoadingViewer : constructeur
+//==============================================================================
+LoadingViewer::LoadingViewer(DatasetLoader& loader) : m_Loader(loader), m_dProgress(loader.Progress()), m_Bar(m_dProgress)
+{
+	addAndMakeVisible(m_Bar);
+	m_Cancel.setButtonText(juce::translate("Cancel"));
+	m_Cancel.onClick = [this] { m_Loader.Cancel(); };
+	addAndMakeVisible(m_Cancel);
+}
+
+void LoadingViewer::resized()
+{
+	auto b = getLocalBounds().reduced(2);
+	m_Cancel.setBounds(b.removeFromRight(80));
+	b.removeFromRight(4);
+	m_Bar.setBounds(b);
+}
@@ -0,0 +1,79 @@
+//==============================================================================
+// DatasetLoader.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <JuceHeader.h>
+#include "GeoBase.h"
+
+//==============================================================================
+// DatasetLoader : ouverture et indexation d'un dataset dans un thread
+// Le message "DatasetLoaded" est envoye a la fin ; le dataset est ensuite
+// ajoute a la base par Commit, depuis le thread des messages
+// Index : construction de l'index de layers deja dans la base (GeoBase::IndexLayers)
+//==============================================================================
+class DatasetLoader : public juce::Thread, public juce::ActionBroadcaster {
+public:
+  typedef enum { Vector = 0, Raster = 1, Dtm = 2, RasterFolder = 3, Index = 4 } DatasetType;
+
+  DatasetLoader(GeoBase* base);
+  ~DatasetLoader() override;
+
+  bool Load(const juce::String& filename, DatasetType type, const juce::String& name = "");
+  // Les layers ne doivent pas etre retires de la base avant la fin de l'indexation
+  bool IndexLayers(const std::vector<GeoBase::VectorLayer*>& layers);
+  bool Commit();
+  void Cancel() { signalThreadShouldExit(); }
+  bool IsLoading() { return isThreadRunning() || m_bPending; }
+  bool Succeeded() { return m_bSuccess; }
+  bool Cancelled() { return m_bCancelled; }
+  juce::String Filename() { return m_Filename; }
+  DatasetType Type() { return m_Type; }
+  double Progress() { return m_dProgress; }
+  juce::String Status();
+
+  void run() override;
+
+private:
+  GeoBase*          m_Base;
+  GeoBase::Loading  m_Loading;      // Dataset lu, en attente d'ajout a la base
+  std::vector<GeoBase::VectorLayer*> m_Layers;  // Layers a indexer
+  juce::String      m_Filename;
+  juce::String      m_Name;
+  DatasetType       m_Type;
+  std::atomic<double> m_dProgress;  // Ecrit par le thread de chargement, lu par la barre de progression
+  juce::String      m_Status;
+  juce::String      m_FeatureText;  // Texte traduit de la progression
+  std::mutex        m_Mutex;        // Acces a m_Status
+  bool              m_bPending;     // Dataset lu et pas encore ajoute
+  std::atomic<bool> m_bSuccess;
+  std::atomic<bool> m_bCancelled;
+
+  static int CPL_STDCALL ProgressCallback(double complete, const char* message, void* data);
+};
+
+//==============================================================================
+// LoadingViewer : progression du chargement, avec un bouton d'annulation
+//==============================================================================
+class LoadingViewer : public juce::Component, private juce::Timer {
+public:
+  LoadingViewer(DatasetLoader& loader);
+  ~LoadingViewer() override { stopTimer(); }
+
+  void resized() override;
+  void visibilityChanged() override { if (isVisible()) startTimer(100); else stopTimer(); }
+
+private:
+  DatasetLoader&    m_Loader;
+  double            m_dProgress;    // Copie de la progression du chargement, lue par m_Bar
+  juce::ProgressBar m_Bar;
+  juce::TextButton  m_Cancel;
+
+  void timerCallback() override { m_dProgress = m_Loader.Progress(); m_Bar.setTextToDisplay(m_Loader.Status()); }
+};
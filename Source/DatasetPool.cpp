@@ -0,0 +1,216 @@
+//==============================================================================
+// DatasetPool.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "DatasetPool.h"
+
+//==============================================================================
+// Lease : transfert et restitution
+//==============================================================================
+DatasetPool::Lease& DatasetPool::Lease::operator=(Lease&& lease)
+{
+	if (this != &lease) {
+		Release();
+		m_Pool = lease.m_Pool;
+		m_Handle = lease.m_Handle;
+		lease.m_Pool = nullptr;
+		lease.m_Handle = nullptr;
+	}
+	return *this;
+}
+
+void DatasetPool::Lease::Release()
+{
+	if ((m_Pool != nullptr) && (m_Handle != nullptr))
+		m_Pool->Release(m_Handle);
+	m_Pool = nullptr;
+	m_Handle = nullptr;
+}
+
+//==============================================================================
+// Constructeur : idleTime en secondes
+//==============================================================================
+DatasetPool::DatasetPool(size_t maxHandle, int idleTime)
+{
+	m_nMaxHandle = maxHandle;
+	m_IdleTime = std::chrono::seconds(idleTime);
+}
+
+//==============================================================================
+// Pool de l'application
+//==============================================================================
+DatasetPool& DatasetPool::Instance()
+{
+	static DatasetPool pool;
+	return pool;
+}
+
+//==============================================================================
+// Emprunt d'un dataset : celui deja utilise par le thread, sinon un dataset
+// libre du meme fichier, sinon un nouveau dataset (en fermant au besoin le
+// dataset libre le plus ancien)
+//==============================================================================
+DatasetPool::Lease DatasetPool::Acquire(const std::string& filename, unsigned int flags)
+{
+	Lease lease;
+	std::vector<GDALDataset*> closed;
+	std::thread::id thread = std::this_thread::get_id();
+	Handle* handle = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		CloseIdle(closed, false);
+		Handle* other = nullptr;
+		for (auto iter = m_Handle.begin(); iter != m_Handle.end(); ++iter) {
+			if ((iter->InUse) || (iter->Flags != flags) || (iter->Filename != filename))
+				continue;
+			if (iter->Thread == thread) {
+				handle = &(*iter);
+				break;
+			}
+			if (other == nullptr)
+				other = &(*iter);
+		}
+		if (handle == nullptr)
+			handle = other;
+		if (handle != nullptr) {
+			handle->InUse = true;
+			handle->Thread = thread;
+			lease.m_Pool = this;
+			lease.m_Handle = handle;
+		}
+		else {
+			if (m_Handle.size() >= m_nMaxHandle) {	// Fermeture du dataset libre le plus ancien
+				auto oldest = m_Handle.end();
+				for (auto iter = m_Handle.begin(); iter != m_Handle.end(); ++iter)
+					if ((!iter->InUse) && ((oldest == m_Handle.end()) || (iter->LastUse < oldest->LastUse)))
+						oldest = iter;
+				if (oldest != m_Handle.end()) {
+					closed.push_back(oldest->Dataset);
+					m_Handle.erase(oldest);
+				}
+			}
+			if (m_Handle.size() < m_nMaxHandle) {	// Place reservee : l'ouverture se fait hors du verrou
+				m_Handle.push_back({ filename, flags, nullptr, thread, true, std::chrono::steady_clock::now(), Generation(filename) });
+				handle = &m_Handle.back();
+			}
+		}
+	}
+	CloseDatasets(closed);
+	if ((lease.m_Handle != nullptr) || (handle == nullptr))	// Dataset trouve, ou tous les datasets sont empruntes
+		return lease;
+
+	GDALDataset* poDataset = GDALDataset::Open(filename.c_str(), flags);
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (poDataset == nullptr) {
+		for (auto iter = m_Handle.begin(); iter != m_Handle.end(); ++iter)
+			if (&(*iter) == handle) {
+				m_Handle.erase(iter);
+				break;
+			}
+		return lease;
+	}
+	handle->Dataset = poDataset;
+	lease.m_Pool = this;
+	lease.m_Handle = handle;
+	return lease;
+}
+
+//==============================================================================
+// Restitution d'un dataset : un dataset ouvert avant la derniere fermeture de
+// son fichier (Close) est ferme
+//==============================================================================
+void DatasetPool::Release(Handle* handle)
+{
+	std::vector<GDALDataset*> closed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		handle->InUse = false;
+		handle->LastUse = std::chrono::steady_clock::now();
+		if (handle->Generation != Generation(handle->Filename)) {
+			for (auto iter = m_Handle.begin(); iter != m_Handle.end(); ++iter)
+				if (&(*iter) == handle) {
+					closed.push_back(iter->Dataset);
+					m_Handle.erase(iter);
+					break;
+				}
+		}
+	}
+	CloseDatasets(closed);
+}
+
+//==============================================================================
+// Generation courante d'un fichier, doit etre appele avec m_Mutex verrouille
+//==============================================================================
+unsigned int DatasetPool::Generation(const std::string& filename)
+{
+	auto iter = m_Generation.find(filename);
+	if (iter == m_Generation.end())
+		return 0;
+	return iter->second;
+}
+
+//==============================================================================
+// Fermeture des datasets d'un fichier : les datasets libres sont fermes, les
+// datasets empruntes deviennent perimes et seront fermes a leur restitution
+//==============================================================================
+void DatasetPool::Close(const std::string& filename)
+{
+	std::vector<GDALDataset*> closed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Generation[filename]++;
+		CloseIdle(closed, true, filename);
+	}
+	CloseDatasets(closed);
+}
+
+void DatasetPool::EvictIdle()
+{
+	std::vector<GDALDataset*> closed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		CloseIdle(closed, false);
+	}
+	CloseDatasets(closed);
+}
+
+void DatasetPool::Clear()
+{
+	std::vector<GDALDataset*> closed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		CloseIdle(closed, true);
+	}
+	CloseDatasets(closed);
+}
+
+//==============================================================================
+// Retire du pool les datasets libres : tous (all) ou ceux inutilises depuis
+// m_IdleTime ; filename restreint la recherche a un fichier
+// Doit etre appele avec m_Mutex verrouille ; les datasets sont fermes ensuite
+//==============================================================================
+void DatasetPool::CloseIdle(std::vector<GDALDataset*>& closed, bool all, const std::string& filename)
+{
+	auto now = std::chrono::steady_clock::now();
+	for (auto iter = m_Handle.begin(); iter != m_Handle.end(); ) {
+		bool close = (!iter->InUse) && (all || (now - iter->LastUse > m_IdleTime)) &&
+			((filename.size() < 1) || (iter->Filename == filename));
+		if (close) {
+			closed.push_back(iter->Dataset);
+			iter = m_Handle.erase(iter);
+		}
+		else
+			++iter;
+	}
+}
+
+void DatasetPool::CloseDatasets(std::vector<GDALDataset*>& closed)
+{
+	for (size_t i = 0; i < closed.size(); i++)
+		if (closed[i] != nullptr)
+			GDALClose(closed[i]);
+	closed.clear();
+}
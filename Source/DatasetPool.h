@@ -0,0 +1,82 @@
+//==============================================================================
+// DatasetPool.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gdal_priv.h"
+
+//==============================================================================
+// DatasetPool : datasets GDAL ouverts a la demande pour chaque thread
+// Un GDALDataset ne doit etre utilise que par un thread a la fois : un thread
+// emprunte un dataset (Lease), de preference celui qu'il a deja utilise.
+// Le nombre de datasets ouverts est borne et les datasets inutilises depuis
+// un certain temps sont fermes
+//==============================================================================
+class DatasetPool {
+protected:
+	typedef struct {
+		std::string			Filename;
+		unsigned int		Flags;
+		GDALDataset*		Dataset;
+		std::thread::id	Thread;			// Dernier thread utilisateur
+		bool						InUse;
+		std::chrono::steady_clock::time_point LastUse;
+		unsigned int		Generation;	// Generation du fichier a l'ouverture
+	} Handle;
+
+public:
+	// Emprunt d'un dataset, rendu au pool a la destruction
+	class Lease {
+	public:
+		Lease() { m_Pool = nullptr; m_Handle = nullptr; }
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		Lease(Lease&& lease) { m_Pool = lease.m_Pool; m_Handle = lease.m_Handle; lease.m_Pool = nullptr; lease.m_Handle = nullptr; }
+		Lease& operator=(Lease&& lease);
+		virtual ~Lease() { Release(); }
+		GDALDataset* Dataset() { if (m_Handle != nullptr) return m_Handle->Dataset; return nullptr; }
+		void Release();
+	private:
+		friend class DatasetPool;
+		DatasetPool*	m_Pool;
+		Handle*				m_Handle;
+	};
+
+	DatasetPool(size_t maxHandle = 32, int idleTime = 30);
+	virtual ~DatasetPool() { Clear(); }
+	static DatasetPool& Instance();
+
+	void SetMaxHandle(size_t maxHandle) { std::lock_guard<std::mutex> lock(m_Mutex); m_nMaxHandle = maxHandle; }
+	void SetIdleTime(int seconds) { std::lock_guard<std::mutex> lock(m_Mutex); m_IdleTime = std::chrono::seconds(seconds); }
+	size_t Count() { std::lock_guard<std::mutex> lock(m_Mutex); return m_Handle.size(); }
+
+	// Renvoie un Lease vide si le dataset ne peut pas etre ouvert ou si tous les datasets sont empruntes
+	Lease Acquire(const std::string& filename, unsigned int flags);
+	// Fermeture des datasets d'un fichier modifie : les datasets empruntes sont fermes a leur restitution
+	void Close(const std::string& filename);
+	void EvictIdle();
+	void Clear();
+
+protected:
+	std::mutex			m_Mutex;
+	std::list<Handle>	m_Handle;	// Liste : les adresses des Handle restent valides
+	std::map<std::string, unsigned int> m_Generation;	// Incrementee par Close : les datasets plus anciens sont perimes
+	size_t					m_nMaxHandle;
+	std::chrono::steady_clock::duration m_IdleTime;
+
+	void Release(Handle* handle);
+	unsigned int Generation(const std::string& filename);
+	void CloseIdle(std::vector<GDALDataset*>& closed, bool all, const std::string& filename = "");
+	static void CloseDatasets(std::vector<GDALDataset*>& closed);
+};
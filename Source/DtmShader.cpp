@@ -340,4 +340,40 @@ bool DtmShader::ConvertImage(juce::Image* rawImage, juce::Image* rgbImage)
                 w, rgbData.getLinePointer(h - 1), h - 1);
   return true;
 
+}
+
+//-----------------------------------------------------------------------------
+// Calcul de l'estompage d'une zone de l'image seulement (bandes decouvertes
+// par un deplacement de la vue). Les voisins hors de la zone sont lus dans
+// l'image brute : le resultat est identique au calcul sur toute l'image
+//-----------------------------------------------------------------------------
+bool DtmShader::ConvertImage(juce::Image* rawImage, juce::Image* rgbImage, const juce::Rectangle<int>& area)
+{
+  if ((rawImage->getWidth() != rgbImage->getWidth()) || (rawImage->getHeight() != rgbImage->getHeight()))
+    return false;
+  if (rawImage->getFormat() != juce::Image::PixelFormat::ARGB)
+    return false;
+  if (rgbImage->getFormat() != juce::Image::PixelFormat::ARGB)
+    return false;
+  juce::Rectangle<int> zone = area.getIntersection(rawImage->getBounds());
+  if (zone.isEmpty())
+    return true;
+  if ((zone == rawImage->getBounds()) || (rawImage->getHeight() < 2))
+    return ConvertImage(rawImage, rgbImage);
+  int w = rawImage->getWidth(), h = rawImage->getHeight();
+  int x0 = zone.getX();
+  int n = juce::jmin(zone.getRight() + 1, w) - x0;  // Une colonne de plus pour le voisin de droite
+
+  juce::Image::BitmapData rawData(*rawImage, juce::Image::BitmapData::readWrite);
+  juce::Image::BitmapData rgbData(*rgbImage, juce::Image::BitmapData::readWrite);
+  std::vector<juce::uint8> line(4 * n);
+
+  for (int i = zone.getY(); i < zone.getBottom(); i++) {
+    float* lineR = (float*)rawData.getLinePointer(juce::jmax(i - 1, 0)) + x0;
+    float* lineS = (float*)rawData.getLinePointer(i) + x0;
+    float* lineT = (float*)rawData.getLinePointer(juce::jmin(i + 1, h - 1)) + x0;
+    EstompLine(lineR, lineS, lineT, n, line.data(), i);
+    ::memcpy(rgbData.getLinePointer(i) + 4 * x0, line.data(), 4 * zone.getWidth());
+  }
+  return true;
 }
\ No newline at end of file
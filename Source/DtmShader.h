@@ -23,6 +23,7 @@ protected:
 public:
   DtmShader(double gsd = 25.);
   bool ConvertImage(juce::Image* rawImage, juce::Image* rgbImage);
+  bool ConvertImage(juce::Image* rawImage, juce::Image* rgbImage, const juce::Rectangle<int>& area);
 
   enum class ShaderMode { Altitude = 0, Shading, Light_Shading, Free_Shading, Slope, Colour, Shading_Colour, Contour};
 
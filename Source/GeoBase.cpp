@@ -5,7 +5,14 @@
 // Date : 14/12/2021
 //==============================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <JuceHeader.h>
 #include "GeoBase.h"
+#include "RasterCache.h"
 #include "gdal_priv.h"
 #include "cpl_conv.h" // for CPLMalloc()
 #include "cpl_string.h"
@@ -16,6 +23,27 @@
 GeoBase::GeoBase()
 {
 	m_SpatialRef.importFromEPSG(3857);
+	m_nCacheBudget = 64 * 1024 * 1024;
+	m_nFieldLayer = -1;
+	m_nFieldFeature = OGRNullFID;
+}
+
+GeoBase::~GeoBase()
+{
+	Clear();
+}
+
+//==============================================================================
+// Budget memoire du cache de geometries de chaque layer vectoriel
+//==============================================================================
+void GeoBase::SetCacheBudget(size_t budget)
+{
+	m_nCacheBudget = budget;
+	for (size_t i = 0; i < m_VLayers.size(); i++) {
+		std::lock_guard<std::mutex> lock(m_VLayers[i]->Mutex());
+		std::lock_guard<std::mutex> drawLock(m_VLayers[i]->DrawMutex());
+		m_VLayers[i]->Cache()->SetBudget(budget);
+	}
 }
 
 //==============================================================================
@@ -25,7 +53,8 @@ void GeoBase::Clear()
 {
 	m_Env = OGREnvelope();
 	m_Selection.clear();
-	m_Field.clear();
+	m_nFieldLayer = -1;
+	m_nFieldFeature = OGRNullFID;
 	for (int i = 0; i < m_VLayers.size(); i++)
 		delete m_VLayers[i];
 	m_VLayers.clear();
@@ -38,6 +67,9 @@ void GeoBase::Clear()
 	for (int i = 0; i < m_Dataset.size(); i++)
 		m_Dataset[i]->Release();
 	m_Dataset.clear();
+	m_File.clear();
+	DatasetPool::Instance().Clear();
+	RasterCache::Instance().Clear();
 }
 
 //==============================================================================
@@ -45,36 +77,63 @@ void GeoBase::Clear()
 //==============================================================================
 bool GeoBase::OpenVectorDataset(const char* filename, char** options)
 {
+	Loading loading;
+	if (!LoadVectorDataset(filename, loading, nullptr, nullptr, options))
+		return false;
+	return AddLoading(loading);
+}
+
+//==============================================================================
+// Ouverture d'un dataset raster
+//==============================================================================
+bool GeoBase::OpenRasterDataset(const char* filename, const char* name, bool visible, char** options, bool dtm)
+{
+	Loading loading;
+	if (!LoadRasterDataset(filename, loading, name, visible, options, dtm))
+		return false;
+	return AddLoading(loading);
+}
+
+//==============================================================================
+// Lecture d'un dataset vectoriel sans modifier la base
+// Seules les metadonnees des layers sont lues : l'index d'un layer est construit
+// par IndexLayers quand il est affiche. La progression peut interrompre la lecture
+//==============================================================================
+bool GeoBase::LoadVectorDataset(const char* filename, Loading& loading, GDALProgressFunc progress, void* progressData, char** options)
+{
+	loading.Clear();
 	GDALDataset* poDataset = GDALDataset::Open(filename, GDAL_OF_VECTOR | GDAL_OF_READONLY, nullptr, options);
 	if (poDataset == NULL) 
 		return false;
+	loading.Dataset = poDataset;
+	loading.ListFiles(filename);
 
-	// Analyse des layers
-	OGREnvelope total;
-	for (int i = 0; i < poDataset->GetLayerCount(); i++) {
+	std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
+	int nbLayer = poDataset->GetLayerCount();
+	for (int i = 0; i < nbLayer; i++) {
 		if (poDataset->IsLayerPrivate(i))
 			continue;
-		VectorLayer* layer = new VectorLayer(GetVectorLayerCount()+1);
+		VectorLayer* layer = new VectorLayer(0);
 		if (layer == nullptr)
 			continue;
-		if (!layer->SetDataset(poDataset, i)) {
+		if (layer->SetDataset(poDataset, i, mutex, m_IndexFolder))
+			loading.VLayers.push_back(layer);
+		else
 			delete layer;
-			continue;
+		if ((progress != nullptr) && (!progress((double)(i + 1) / nbLayer, nullptr, progressData))) {	// Interruption
+			loading.Clear();
+			return false;
 		}
-		m_VLayers.push_back(layer);
-		total = layer->Envelope();
-		m_Env.Merge(ConvertEnvelop(total, layer->SpatialRef(), &m_SpatialRef));
 	}
-	m_Dataset.push_back(poDataset);
-
 	return true;
 }
 
 //==============================================================================
-// Ouverture d'un dataset raster
+// Lecture d'un dataset raster sans modifier la base
 //==============================================================================
-bool GeoBase::OpenRasterDataset(const char* filename, const char* name, bool visible, char** options, bool dtm)
+bool GeoBase::LoadRasterDataset(const char* filename, Loading& loading, const char* name, bool visible, char** options, bool dtm)
 {
+	loading.Clear();
 	GDALDataset* poDataset = GDALDataset::Open(filename, GDAL_OF_RASTER | GDAL_OF_READONLY, nullptr, options);
 	if (poDataset == NULL)
 		return false;
@@ -84,12 +143,10 @@ bool GeoBase::OpenRasterDataset(const char* filename, const char* name, bool vis
 		if (name != nullptr)
 			layer->Name(name);
 		layer->Visible = visible;
-		if (dtm)
-			m_ZLayers.push_back(layer);
-		else
-			m_RLayers.push_back(layer);
-		m_Dataset.push_back(poDataset);
-		m_Env.Merge(layer->Envelope());
+		loading.Dataset = poDataset;
+		loading.RLayer = layer;
+		loading.Dtm = dtm;
+		loading.ListFiles(filename);
 		return true;
 	}
 	delete layer;
@@ -97,6 +154,202 @@ bool GeoBase::OpenRasterDataset(const char* filename, const char* name, bool vis
 	return false;
 }
 
+//==============================================================================
+// Lecture d'un repertoire d'images formant un seul layer raster, sans modifier la base
+// Chaque fichier n'est ouvert que le temps de lire sa geometrie : les rasters sont
+// ouverts a la demande pour l'affichage. La progression peut interrompre la lecture
+//==============================================================================
+bool GeoBase::LoadRasterFolder(const char* folder, Loading& loading, const char* name, GDALProgressFunc progress, void* progressData, bool dtm)
+{
+	loading.Clear();
+	char** files = VSIReadDir(folder);
+	int nbFile = CSLCount(files);
+	RasterLayer* layer = new RasterLayer;
+	for (int i = 0; i < nbFile; i++) {
+		std::string filename = CPLFormFilename(folder, files[i], nullptr);
+		VSIStatBufL stat;
+		if ((VSIStatL(filename.c_str(), &stat) == 0) && (!VSI_ISDIR(stat.st_mode)) && (!EQUAL(CPLGetExtension(files[i]), "ovr")))
+			if (layer->AddFile(filename.c_str()))
+				loading.Files.push_back(CanonicalPath(filename.c_str()));
+		if ((progress != nullptr) && (!progress((double)(i + 1) / nbFile, nullptr, progressData))) {	// Interruption
+			delete layer;
+			CSLDestroy(files);
+			return false;
+		}
+	}
+	CSLDestroy(files);
+	if (layer->GetRasterCount() < 1) {
+		delete layer;
+		return false;
+	}
+	if (name != nullptr)
+		layer->Name(name);
+	loading.RLayer = layer;
+	loading.Dtm = dtm;
+	return true;
+}
+
+//==============================================================================
+// Ajout d'un dataset lu par LoadVectorDataset, LoadRasterDataset ou LoadRasterFolder
+// Le thread de dessin doit etre arrete
+//==============================================================================
+bool GeoBase::AddLoading(Loading& loading)
+{
+	if ((loading.Dataset == nullptr) && (loading.RLayer == nullptr))
+		return false;
+	for (size_t i = 0; i < loading.VLayers.size(); i++) {
+		VectorLayer* layer = loading.VLayers[i];
+		layer->SetId(GetVectorLayerCount() + 1);
+		layer->Cache()->SetBudget(m_nCacheBudget);
+		m_VLayers.push_back(layer);
+		if (layer->Envelope().IsInit())
+			m_Env.Merge(ConvertEnvelop(layer->Envelope(), layer->SpatialRef(), &m_SpatialRef));
+	}
+	if (loading.RLayer != nullptr) {
+		if (loading.Dtm)
+			m_ZLayers.push_back(loading.RLayer);
+		else
+			m_RLayers.push_back(loading.RLayer);
+		m_Env.Merge(loading.RLayer->Envelope());
+	}
+	if (loading.Dataset != nullptr)	// Les layers raster d'un repertoire n'ont pas de dataset
+		m_Dataset.push_back(loading.Dataset);
+	for (size_t i = 0; i < loading.Files.size(); i++)	// Fichiers d'un repertoire : sans dataset
+		m_File[loading.Files[i]] = loading.Dataset;
+	loading.Release();
+	return true;
+}
+
+//==============================================================================
+// Layers vecteurs visibles dont l'index n'est pas encore construit
+//==============================================================================
+std::vector<GeoBase::VectorLayer*> GeoBase::UnindexedLayers()
+{
+	std::vector<VectorLayer*> layers = VisibleVectorLayers();
+	layers.erase(std::remove_if(layers.begin(), layers.end(), [](VectorLayer* layer) { return layer->Materialized(); }), layers.end());
+	return layers;
+}
+
+//==============================================================================
+// Construction de l'index des layers, depuis le thread de chargement
+// La progression couvre tous les layers ; elle peut interrompre la lecture
+// Un layer illisible n'empeche pas l'indexation des suivants : renvoie false
+// si un layer n'a pas ete indexe
+//==============================================================================
+bool GeoBase::IndexLayers(const std::vector<VectorLayer*>& layers, GDALProgressFunc progress, void* progressData)
+{
+	bool flag = true;
+	for (size_t i = 0; i < layers.size(); i++) {
+		void* scaled = nullptr;
+		if (progress != nullptr)
+			scaled = GDALCreateScaledProgress((double)i / layers.size(), (double)(i + 1) / layers.size(), progress, progressData);
+		bool ok = layers[i]->Materialize((scaled != nullptr) ? GDALScaledProgress : nullptr, scaled);
+		if (scaled != nullptr)
+			GDALDestroyScaledProgress(scaled);
+		flag &= ok;
+		if ((!ok) && (progress != nullptr) && (!progress((double)(i + 1) / layers.size(), nullptr, progressData)))
+			return false;	// Interruption
+	}
+	return flag;
+}
+
+//==============================================================================
+// Layers dont l'indexation a ete interrompue ou a echoue : ils sont caches, ils
+// seront indexes quand ils seront a nouveau affiches
+//==============================================================================
+void GeoBase::HideUnindexedLayers()
+{
+	std::vector<VectorLayer*> layers = UnindexedLayers();
+	for (size_t i = 0; i < layers.size(); i++)
+		layers[i]->m_Repres.Visible = false;
+}
+
+//==============================================================================
+// Ajout a l'emprise de la base des emprises calculees par l'indexation des layers
+// (layers dont le driver ne connait pas l'emprise sans lire les features)
+//==============================================================================
+void GeoBase::UpdateEnvelope()
+{
+	for (size_t i = 0; i < m_VLayers.size(); i++) {
+		VectorLayer* layer = m_VLayers[i];
+		if ((layer->Materialized()) && (layer->Envelope().IsInit()))
+			m_Env.Merge(ConvertEnvelop(layer->Envelope(), layer->SpatialRef(), &m_SpatialRef));
+	}
+}
+
+//==============================================================================
+// Remplacement d'un dataset par un nouveau handle du meme fichier (rouvert apres
+// le calcul de ses apercus par exemple). Le thread de dessin doit etre arrete
+// Le nouveau dataset appartient a la base, meme si l'ancien n'y est plus
+//==============================================================================
+bool GeoBase::ReplaceDataset(GDALDataset* oldDataset, GDALDataset* newDataset)
+{
+	if (newDataset == nullptr)
+		return false;
+	auto iter = std::find(m_Dataset.begin(), m_Dataset.end(), oldDataset);
+	if (iter == m_Dataset.end()) {
+		newDataset->Release();
+		return false;
+	}
+	*iter = newDataset;
+	for (size_t i = 0; i < m_RLayers.size(); i++)
+		m_RLayers[i]->ReplaceDataset(oldDataset, newDataset);
+	for (size_t i = 0; i < m_ZLayers.size(); i++)
+		m_ZLayers[i]->ReplaceDataset(oldDataset, newDataset);
+	for (auto file = m_File.begin(); file != m_File.end(); ++file)
+		if (file->second == oldDataset)
+			file->second = newDataset;
+	oldDataset->Release();
+	return true;
+}
+
+//==============================================================================
+// Mise a jour du nombre d'apercus d'un raster ouvert a la demande, apres leur
+// calcul. Le thread de dessin doit etre arrete
+//==============================================================================
+bool GeoBase::UpdateOverviews(const std::string& filename, int overviews)
+{
+	bool flag = false;
+	for (size_t i = 0; i < m_RLayers.size(); i++)
+		flag |= m_RLayers[i]->UpdateOverviews(filename, overviews);
+	for (size_t i = 0; i < m_ZLayers.size(); i++)
+		flag |= m_ZLayers[i]->UpdateOverviews(filename, overviews);
+	return flag;
+}
+
+//==============================================================================
+// Liberation d'un dataset qui n'a pas ete ajoute a la base
+//==============================================================================
+void GeoBase::Loading::Clear()
+{
+	for (size_t i = 0; i < VLayers.size(); i++)
+		delete VLayers[i];
+	VLayers.clear();
+	if (RLayer != nullptr)
+		delete RLayer;
+	RLayer = nullptr;
+	if (Dataset != nullptr)
+		Dataset->Release();
+	Dataset = nullptr;
+	Dtm = false;
+	Files.clear();
+}
+
+//==============================================================================
+// Liste des fichiers du dataset, lue une seule fois a l'ouverture
+//==============================================================================
+void GeoBase::Loading::ListFiles(const char* filename)
+{
+	Files.clear();
+	Files.push_back(CanonicalPath(filename));
+	if (Dataset == nullptr)
+		return;
+	char** fileList = Dataset->GetFileList();
+	for (int i = 0; i < CSLCount(fileList); i++)
+		Files.push_back(CanonicalPath(fileList[i]));
+	CSLDestroy(fileList);
+}
+
 //==============================================================================
 // Ouverture d'un multi-dataset raster (WMTS par exemple)
 //==============================================================================
@@ -136,21 +389,137 @@ bool GeoBase::OpenRasterMultiDataset(const char* filename)
 }
 
 //==============================================================================
-// Indique si un fichier est deja ouvert dans les datasets
+// Fichier deja ouvert, avec un dataset ou dans un repertoire d'images
 //==============================================================================
 bool GeoBase::IsOpen(const char* filename)
 {
-	for (size_t i = 0; i < m_Dataset.size(); i++) {
-		GDALDataset* poDataset = m_Dataset[i];
-		char** fileList = poDataset->GetFileList();
-		if (fileList == nullptr)
+	return m_File.find(CanonicalPath(filename)) != m_File.end();
+}
+
+//==============================================================================
+// Dataset contenant un fichier, nullptr si le fichier n'est pas ouvert
+// ou s'il est ouvert a la demande (repertoire d'images)
+//==============================================================================
+GDALDataset* GeoBase::FindDataset(const char* filename)
+{
+	auto iter = m_File.find(CanonicalPath(filename));
+	if (iter == m_File.end())
+		return nullptr;
+	return iter->second;
+}
+
+//==============================================================================
+// Chemin canonique d'un fichier : chemin absolu, separateurs '/', sans '.' ni '..'
+// Les liens symboliques d'un fichier existant sont resolus
+// Sous Windows, les chemins sont insensibles a la casse
+//==============================================================================
+std::string GeoBase::CanonicalPath(const char* filename)
+{
+	if (filename == nullptr)
+		return "";
+	std::string path = filename;
+	if ((CPLIsFilenameRelative(filename)) && (strchr(filename, ':') == nullptr)) {	// Pas les connexions (WMTS:, PG: ...)
+		char* dir = CPLGetCurrentDir();
+		if (dir != nullptr)
+			path = std::string(dir) + "/" + path;
+		CPLFree(dir);
+	}
+#ifdef _WIN32
+	juce::File file(juce::String::fromUTF8(path.c_str()));
+	if ((!CPLIsFilenameRelative(path.c_str())) && (file.exists()))
+		path = file.getLinkedTarget().getFullPathName().toStdString();
+#else
+	char* real = realpath(path.c_str(), nullptr);
+	if (real != nullptr) {
+		path = real;
+		free(real);
+	}
+#endif
+	std::replace(path.begin(), path.end(), '\\', '/');
+#ifdef _WIN32
+	std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return (char)tolower(c); });
+#endif
+	std::vector<std::string> parts;
+	auto root = [&]() { return (parts.size() == 1) && ((parts[0].empty()) || (parts[0].back() == ':')); };	// "/" ou "c:/"
+	size_t start = 0;
+	while (start <= path.size()) {
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+			end = path.size();
+		std::string part = path.substr(start, end - start);
+		if ((part == "..") && (parts.size() > 1) && (parts.back() != ".."))
+			parts.pop_back();
+		else if ((part == "..") && (root()))	// La racine est conservee
+			;
+		else if ((part != ".") && ((part.size() > 0) || (parts.size() < 1)))
+			parts.push_back(part);
+		start = end + 1;
+	}
+	std::string result;
+	for (size_t i = 0; i < parts.size(); i++)
+		result += (i > 0) ? "/" + parts[i] : parts[i];
+	if (root())
+		result += "/";
+	return result;
+}
+
+//==============================================================================
+// Layers vecteurs visibles
+//==============================================================================
+std::vector<GeoBase::VectorLayer*> GeoBase::VisibleVectorLayers()
+{
+	std::vector<VectorLayer*> layers;
+	for (int i = 0; i < GetVectorLayerCount(); i++) {
+		VectorLayer* poLayer = GetVectorLayer(i);
+		if (poLayer == nullptr)
 			continue;
-		if (CSLFindString(fileList, filename) != -1) {
-			CSLDestroy(fileList);
-			return true;
-		}
-		CSLDestroy(fileList);
+		if (poLayer->m_Repres.Visible)
+			layers.push_back(poLayer);
 	}
+	return layers;
+}
+
+//==============================================================================
+// Traitement des layers en parallele par les threads de la base, crees au premier
+// appel, et par le thread appelant. job(i) traite le i-eme layer
+//==============================================================================
+void GeoBase::ForEachLayer(size_t nbLayer, const std::function<void(size_t)>& job)
+{
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next++) < nbLayer)
+			job(i);
+	};
+	if ((nbLayer <= 1) || (juce::SystemStats::getNumCpus() <= 1)) {
+		worker();
+		return;
+	}
+	if (m_Pool == nullptr)
+		m_Pool.reset(new juce::ThreadPool(juce::jmax(1, juce::SystemStats::getNumCpus() - 1)));
+	size_t nbJob = std::min<size_t>(nbLayer - 1, (size_t)m_Pool->getNumThreads());
+	std::atomic<size_t> nbFinished(0);
+	juce::WaitableEvent finished;
+	for (size_t k = 0; k < nbJob; k++)
+		m_Pool->addJob([&]() {
+			worker();
+			if (++nbFinished == nbJob)
+				finished.signal();
+		});
+	worker();
+	finished.wait();
+}
+
+//==============================================================================
+// Indique si un layer visible ne peut etre selectionne qu'avec le dataset partage
+// avec le dessin : le thread de dessin doit alors etre arrete avant la selection
+//==============================================================================
+bool GeoBase::SharedSelection()
+{
+	std::vector<VectorLayer*> layers = VisibleVectorLayers();
+	for (size_t i = 0; i < layers.size(); i++)
+		if (layers[i]->SharedSelection())
+			return true;
 	return false;
 }
 
@@ -162,72 +531,109 @@ size_t GeoBase::SelectFeatures(const OGREnvelope& env, OGRSpatialReference* spat
 	m_Selection.clear();
 	if (!OGRGeometryFactory::haveGEOS())
 		return 0;
-	for (int layerId = 0; layerId < GetVectorLayerCount(); layerId++) {
-		VectorLayer* poLayer = GetVectorLayer(layerId);
-		if (poLayer == nullptr)
-			continue;
-		if (!poLayer->m_Repres.Visible)
-			continue;
-		poLayer->SetSpatialFilterRect(env, spatialRef);
-		poLayer->ResetReading();
-		OGRLinearRing ring;
-		OGRPolygon poly;
-		ring.addPoint(env.MinX, env.MinY);
-		ring.addPoint(env.MaxX, env.MinY);
-		ring.addPoint(env.MaxX, env.MaxY);
-		ring.addPoint(env.MinX, env.MaxY);
-		ring.addPoint(env.MinX, env.MinY);
-		ring.closeRings();
-		poly.addRing(&ring);
-		if (!poly.IsValid())
-			continue;
-		OGRCoordinateTransformation* poTransfo = OGRCreateCoordinateTransformation(spatialRef, poLayer->SpatialRef());
-		if (poTransfo == nullptr)
-			continue;
-		poly.transform(poTransfo);
+	std::vector<VectorLayer*> layers = VisibleVectorLayers();
+	std::vector<std::vector<Feature> > result(layers.size());
+	ForEachLayer(layers.size(), [&](size_t i) { layers[i]->SelectFeatures(env, spatialRef, result[i]); });
+	for (size_t i = 0; i < result.size(); i++)
+		m_Selection.insert(m_Selection.end(), result[i].begin(), result[i].end());
+	return m_Selection.size();
+}
 
-		OGREnvelope featureEnv;
-		GIntBig featureId;
-		do {
-			OGRFeature* poFeature = poLayer->GetNextFeature();
-			if (poFeature == nullptr)
-				break;
-			OGRGeometry* poGeom = poFeature->GetGeometryRef();
-			if (poGeom->Intersects(&poly) == TRUE) {
-				poGeom->getEnvelope(&featureEnv);
-				featureId = poFeature->GetFID();
-				if (featureId != OGRNullFID)
-					m_Selection.push_back(Feature(poFeature->GetFID(), featureEnv, poLayer->Id()));
-			}
-			OGRFeature::DestroyFeature(poFeature);
-		} while (true);
-		delete poTransfo;
-	}
+//==============================================================================
+// Selection des k features les plus proches d'un point, tous layers confondus
+// tolerance : distance maximale, dans le systeme spatialRef
+// Des que k candidats sont connus, la distance du k-ieme borne la recherche des layers suivants
+// Les ex-aequo du k-ieme sont conserves : le choix entre eux ne depend pas du thread le plus rapide
+//==============================================================================
+size_t GeoBase::SelectNearestFeatures(double x, double y, double tolerance, OGRSpatialReference* spatialRef, size_t k)
+{
+	m_Selection.clear();
+	if ((!OGRGeometryFactory::haveGEOS()) || (k < 1))
+		return 0;
+	std::vector<VectorLayer*> layers = VisibleVectorLayers();
+	// Candidat : distance, layer, rang dans le layer. L'ordre ne depend pas de l'ordre de fin des layers :
+	// distance croissante, puis layer du dessus d'abord (dessine en dernier), puis ordre du layer
+	typedef struct {
+		double	Dist;
+		size_t	Layer;
+		size_t	Rank;
+		Feature	Feat;
+	} Candidate;
+	auto closer = [](const Candidate& a, const Candidate& b) {
+		if (a.Dist != b.Dist) return a.Dist < b.Dist;
+		if (a.Layer != b.Layer) return a.Layer > b.Layer;
+		return a.Rank < b.Rank;
+	};
+	std::vector<Candidate> nearest;	// Les k plus proches et les ex-aequo du k-ieme
+	double bound = tolerance;
+	std::mutex mutex;
+	ForEachLayer(layers.size(), [&](size_t i) {
+		double maxDist;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			maxDist = bound;
+		}
+		std::vector<std::pair<double, Feature> > result;
+		layers[i]->SelectNearestFeatures(x, y, tolerance, maxDist, spatialRef, k, result);
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t j = 0; j < result.size(); j++)
+			nearest.push_back({ result[j].first, i, j, result[j].second });
+		std::sort(nearest.begin(), nearest.end(), closer);
+		if (nearest.size() < k)
+			return;
+		size_t n = k;	// Les ex-aequo du k-ieme sont conserves, comme dans chaque layer
+		while ((n < nearest.size()) && (nearest[n].Dist <= nearest[k - 1].Dist))
+			n++;
+		nearest.erase(nearest.begin() + n, nearest.end());
+		bound = std::min(bound, nearest[k - 1].Dist);
+	});
+	for (size_t i = 0; i < nearest.size(); i++)
+		m_Selection.push_back(nearest[i].Feat);
 	return m_Selection.size();
 }
 
 //==============================================================================
-// Selection des champs d'un feature
+// Selection du feature dont les champs sont consultes : aucune valeur n'est lue ici
 //==============================================================================
 bool GeoBase::SelectFeatureFields(int layerId, GIntBig featureId)
 {
-	m_Field.clear();
-	OGRLayer* poLayer = GetOGRLayer(layerId);
-	if (poLayer == nullptr)
-		return false;
-	OGRFeature* poFeature = poLayer->GetFeature(featureId);
-	if (poFeature == nullptr)
+	m_nFieldLayer = -1;
+	m_nFieldFeature = OGRNullFID;
+	VectorLayer* layer = GetVectorLayerId(layerId);
+	if ((layer == nullptr) || (layer->GetOGRLayer() == nullptr))
 		return false;
-	OGRFeatureDefn* poFDefn = poLayer->GetLayerDefn();
-	for (int iField = 0; iField < poFDefn->GetFieldCount(); iField++) {
-		OGRFieldDefn* poFieldDefn = poFDefn->GetFieldDefn(iField);
-		m_Field.push_back(poFieldDefn->GetNameRef());
-		m_Field.push_back(poFeature->GetFieldAsString(iField));
-	}
-	OGRFeature::DestroyFeature(poFeature);
+	m_nFieldLayer = layerId;
+	m_nFieldFeature = featureId;
 	return true;
 }
 
+//==============================================================================
+// Acces aux champs des features
+//==============================================================================
+int GeoBase::GetFieldCount(int layerId)
+{
+	VectorLayer* layer = GetVectorLayerId(layerId);
+	if (layer == nullptr)
+		return 0;
+	return layer->GetFieldCount();
+}
+
+std::string GeoBase::GetFieldName(int layerId, int i)
+{
+	VectorLayer* layer = GetVectorLayerId(layerId);
+	if (layer == nullptr)
+		return "";
+	return layer->GetFieldName(i);
+}
+
+std::string GeoBase::GetFieldValue(int layerId, GIntBig featureId, int i)
+{
+	VectorLayer* layer = GetVectorLayerId(layerId);
+	if (layer == nullptr)
+		return "";
+	return layer->GetFieldValue(featureId, i);
+}
+
 //==============================================================================
 // Change l'ordre des layers
 //==============================================================================
@@ -274,25 +680,207 @@ template<typename T> static bool GeoBase::ReorderLayer(std::vector<T*>* V, int o
 //==============================================================================
 OGREnvelope GeoBase::ConvertEnvelop(const OGREnvelope& env, OGRSpatialReference* fromRef, OGRSpatialReference* toRef)
 {
-	if ((fromRef == nullptr) || (toRef == nullptr))
+	Transformation* transfo = Transformation::Get(fromRef, toRef);
+	if (transfo == nullptr)
 		return env;
-	OGRCoordinateTransformation* poTransfo = OGRCreateCoordinateTransformation(fromRef, toRef);
-	if (poTransfo == nullptr)
+	return transfo->Transform(env);
+}
+
+//==============================================================================
+// Rectangle inscrit dans l'image d'une enveloppe : les bords sont echantillonnes
+// et le rectangle est limite par le point le plus interieur de chaque bord
+// Renvoie une enveloppe vide si la transformation echoue
+//==============================================================================
+OGREnvelope GeoBase::Transformation::InnerEnvelope(const OGREnvelope& env)
+{
+	if (m_Transfo == nullptr)
 		return env;
+	const int n = 16;
+	double x[4 * n], y[4 * n];
+	for (int k = 0; k < n; k++) {
+		double t = (double)k / (n - 1);
+		x[k] = env.MinX;									y[k] = env.MinY + t * (env.MaxY - env.MinY);	// Gauche
+		x[n + k] = env.MaxX;							y[n + k] = y[k];															// Droite
+		x[2 * n + k] = env.MinX + t * (env.MaxX - env.MinX);	y[2 * n + k] = env.MinY;	// Bas
+		x[3 * n + k] = x[2 * n + k];			y[3 * n + k] = env.MaxY;											// Haut
+	}
+	OGREnvelope inner;
+	if (!Transform(4 * n, x, y))
+		return inner;
+	inner.MinX = *std::max_element(x, x + n);
+	inner.MaxX = *std::min_element(x + n, x + 2 * n);
+	inner.MinY = *std::max_element(y + 2 * n, y + 3 * n);
+	inner.MaxY = *std::min_element(y + 3 * n, y + 4 * n);
+	if ((inner.MinX >= inner.MaxX) || (inner.MinY >= inner.MaxY))
+		return OGREnvelope();
+	return inner;
+}
+
+//==============================================================================
+// Nom et code d'un systeme : verification rapide d'une entree trouvee par pointeur
+//==============================================================================
+static std::string SpatialRefTag(OGRSpatialReference* poRef)
+{
+	const char* name = poRef->GetName();
+	const char* code = poRef->GetAuthorityCode(nullptr);
+	return std::string(name != nullptr ? name : "") + "|" + std::string(code != nullptr ? code : "");
+}
+
+//==============================================================================
+// Recherche d'une transformation dans le cache du thread appelant
+// Les OGRCoordinateTransformation ne doivent pas etre partagees entre threads
+// La recherche se fait d'abord par pointeurs : un pointeur pouvant etre reutilise
+// par un autre systeme, l'entree est verifiee avec le nom et le code des systemes.
+// Le WKT n'est exporte que si le couple de pointeurs est inconnu
+//==============================================================================
+GeoBase::Transformation* GeoBase::Transformation::Get(OGRSpatialReference* fromRef, OGRSpatialReference* toRef)
+{
+	typedef struct {
+		std::string			Tag;
+		Transformation*	Transfo;
+	} RefEntry;
+	thread_local std::map<std::string, std::unique_ptr<Transformation> > cache;
+	thread_local std::map<std::pair<OGRSpatialReference*, OGRSpatialReference*>, RefEntry> refCache;
+	if ((fromRef == nullptr) || (toRef == nullptr))
+		return nullptr;
+	std::string tag = SpatialRefTag(fromRef) + "|" + SpatialRefTag(toRef);
+	auto ref = refCache.find(std::make_pair(fromRef, toRef));
+	if ((ref != refCache.end()) && (ref->second.Tag == tag))
+		return ref->second.Transfo;
+
+	char* fromWkt = nullptr, *toWkt = nullptr;
+	fromRef->exportToWkt(&fromWkt);
+	toRef->exportToWkt(&toWkt);
+	std::string key = std::string(fromWkt != nullptr ? fromWkt : "") + "|" + std::string(toWkt != nullptr ? toWkt : "");
+	CPLFree(fromWkt);
+	CPLFree(toWkt);
+
+	Transformation* transfo = nullptr;
+	auto iter = cache.find(key);
+	if (iter != cache.end())
+		transfo = iter->second.get();
+	else {
+		OGRCoordinateTransformation* poTransfo = nullptr;
+		if (!fromRef->IsSame(toRef)) {
+			poTransfo = OGRCreateCoordinateTransformation(fromRef, toRef);
+			if (poTransfo == nullptr)
+				return nullptr;
+		}
+		transfo = new Transformation(poTransfo);
+		cache[key].reset(transfo);
+	}
+	refCache[std::make_pair(fromRef, toRef)] = { tag, transfo };
+	return transfo;
+}
+
+//==============================================================================
+// Transformation d'un tableau de points
+//==============================================================================
+bool GeoBase::Transformation::Transform(int n, double* x, double* y)
+{
+	if ((m_Transfo == nullptr) || (n < 1))
+		return true;
+	return (m_Transfo->Transform(n, x, y) == TRUE);
+}
+
+//==============================================================================
+// Transformation d'une geometrie : tous les sommets sont transformes en un
+// seul appel sur des tableaux contigus. Les Z ne sont transformes (et conserves)
+// que pour les geometries 3D
+//==============================================================================
+bool GeoBase::Transformation::Transform(OGRGeometry* poGeom)
+{
+	if ((m_Transfo == nullptr) || (poGeom == nullptr))
+		return true;
+	m_X.clear();
+	m_Y.clear();
+	m_Z.clear();
+	m_Parts.clear();
+	if (!Collect(poGeom))	// Geometrie non geree (courbes composees ...)
+		return (poGeom->transform(m_Transfo) == OGRERR_NONE);
+	if (m_X.size() < 1)
+		return true;
+	double* z = poGeom->Is3D() ? m_Z.data() : nullptr;
+	if (m_Transfo->Transform((int)m_X.size(), m_X.data(), m_Y.data(), z) != TRUE)
+		return false;
+	size_t start = 0;
+	for (size_t i = 0; i < m_Parts.size(); i++) {
+		if (wkbFlatten(m_Parts[i]->getGeometryType()) == wkbPoint) {
+			OGRPoint* poPoint = m_Parts[i]->toPoint();
+			poPoint->setX(m_X[start]);
+			poPoint->setY(m_Y[start]);
+			if (poPoint->Is3D())
+				poPoint->setZ(m_Z[start]);
+			start++;
+			continue;
+		}
+		OGRSimpleCurve* poCurve = dynamic_cast<OGRSimpleCurve*>(m_Parts[i]);
+		int n = poCurve->getNumPoints();
+		if (poCurve->Is3D())
+			poCurve->setPoints(n, &m_X[start], &m_Y[start], &m_Z[start]);
+		else
+			poCurve->setPoints(n, &m_X[start], &m_Y[start]);
+		start += n;
+	}
+	return true;
+}
+
+//==============================================================================
+// Recuperation des sommets d'une geometrie dans les tableaux m_X, m_Y et m_Z
+//==============================================================================
+bool GeoBase::Transformation::Collect(OGRGeometry* poGeom)
+{
+	if (poGeom->IsEmpty())
+		return true;
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbPoint) {
+		OGRPoint* poPoint = poGeom->toPoint();
+		m_X.push_back(poPoint->getX());
+		m_Y.push_back(poPoint->getY());
+		m_Z.push_back(poPoint->getZ());
+		m_Parts.push_back(poGeom);
+		return true;
+	}
+	if (OGRSimpleCurve* poCurve = dynamic_cast<OGRSimpleCurve*>(poGeom)) {
+		size_t start = m_X.size();
+		int n = poCurve->getNumPoints();
+		m_X.resize(start + n);
+		m_Y.resize(start + n);
+		m_Z.resize(start + n);
+		poCurve->getPoints(&m_X[start], sizeof(double), &m_Y[start], sizeof(double), &m_Z[start], sizeof(double));
+		m_Parts.push_back(poGeom);
+		return true;
+	}
+	if (OGRCurvePolygon* poPolygon = dynamic_cast<OGRCurvePolygon*>(poGeom)) {
+		if (!Collect(poPolygon->getExteriorRingCurve()))
+			return false;
+		for (int i = 0; i < poPolygon->getNumInteriorRings(); i++)
+			if (!Collect(poPolygon->getInteriorRingCurve(i)))
+				return false;
+		return true;
+	}
+	if (OGRGeometryCollection* poCollection = dynamic_cast<OGRGeometryCollection*>(poGeom)) {
+		for (int i = 0; i < poCollection->getNumGeometries(); i++)
+			if (!Collect(poCollection->getGeometryRef(i)))
+				return false;
+		return true;
+	}
+	return false;
+}
+
+//==============================================================================
+// Transformation d'une enveloppe (les 4 coins en un seul appel)
+//==============================================================================
+OGREnvelope GeoBase::Transformation::Transform(const OGREnvelope& env)
+{
+	if (m_Transfo == nullptr)
+		return env;
+	double X[4] = { env.MinX, env.MinX, env.MaxX, env.MaxX };	// Bottom Left, Top Left, Top Right, Bottom Right
+	double Y[4] = { env.MinY, env.MaxY, env.MaxY, env.MinY };
 	OGREnvelope result;
-	double X = env.MinX, Y = env.MinY;	// Bottom Left
-	poTransfo->Transform(1, &X, &Y);		
-	result.Merge(X, Y);									
-	X = env.MinX; Y = env.MaxY;					// Top Left
-	poTransfo->Transform(1, &X, &Y);		
-	result.Merge(X, Y);
-	X = env.MaxX; Y = env.MaxY;					// Top Right
-	poTransfo->Transform(1, &X, &Y);		
-	result.Merge(X, Y);
-	X = env.MaxX; Y = env.MinY;					// Bottom Right
-	poTransfo->Transform(1, &X, &Y);		
-	result.Merge(X, Y);
-	delete poTransfo;
+	if (m_Transfo->Transform(4, X, Y) != TRUE)
+		return env;
+	for (int i = 0; i < 4; i++)
+		result.Merge(X[i], Y[i]);
 	return result;
 }
 
@@ -303,25 +891,46 @@ GeoBase::VectorLayer::VectorLayer(int id)
 {
 	m_Dataset = nullptr;
 	m_OGRLayer = nullptr; 
+	m_nLayerIndex = -1;
+	m_bPooled = false;
+	m_bReopen = false;
+	m_bMaterialized = false;
 	m_Id = id;
 	m_bFastSpatialFilter = false;
-	m_nIndex = 0;
+	m_bNearest = false;
+	m_Mutex = std::make_shared<std::mutex>();
 	m_Repres.PenColor = 0xFF008800;
 	m_Repres.FillColor = 0x55770000;
 	m_Repres.PenSize = 2.;
+	m_Repres.Decimation = 0.5f;
+	m_Repres.SymbolSize = 6.f;
 	m_Repres.Visible = true;
 }
 
 //==============================================================================
-// Ouverture d'un dataset vectoriel
+// Association au layer id d'un dataset : seules les metadonnees sont lues
+// (nom, systeme, emprise declaree). L'index est lu s'il existe deja ; sinon il
+// sera construit par Materialize, a la premiere utilisation du layer
 //==============================================================================
-bool GeoBase::VectorLayer::SetDataset(GDALDataset* poDataset, int id)
+bool GeoBase::VectorLayer::SetDataset(GDALDataset* poDataset, int id, std::shared_ptr<std::mutex> mutex, const std::string& indexFolder)
 {
 	m_OGRLayer = poDataset->GetLayer(id);
 	if (m_OGRLayer == nullptr)
 		return false;
+	m_Dataset = poDataset;
+	m_Source = poDataset->GetDescription();
+	m_nLayerIndex = id;
+	VSIStatBufL stat;
+	m_bReopen = (VSIStatL(m_Source.c_str(), &stat) == 0);	// Seuls les fichiers peuvent etre rouverts
+	m_bPooled = m_bReopen && ReopenableDriver(poDataset);
+	if (mutex != nullptr)
+		m_Mutex = mutex;
+	// Un fichier shape sans index spatial (.qix) connait son emprise, mais son filtre spatial lit tous
+	// les objets : il est indexe comme les layers sans index, avec une lecture parallele par plages de FID
+	std::string driver = (poDataset->GetDriver() != nullptr) ? poDataset->GetDriver()->GetDescription() : "";
+	bool fastExtent = m_OGRLayer->TestCapability(OLCFastGetExtent) && (driver != "ESRI Shapefile");
 	if ( (m_OGRLayer->TestCapability(OLCFastSpatialFilter)) || 
-		(m_OGRLayer->TestCapability(OLCTransactions)) || (m_OGRLayer->TestCapability(OLCFastGetExtent)) ) {
+		(m_OGRLayer->TestCapability(OLCTransactions)) || (fastExtent) ) {
 		if (m_OGRLayer->TestCapability(OLCTransactions)) {
 			std::string geom = m_OGRLayer->GetGeometryColumn();
 			if (geom.size() < 1) // Layer non geometrique
@@ -329,27 +938,269 @@ bool GeoBase::VectorLayer::SetDataset(GDALDataset* poDataset, int id)
 		}
 		m_bFastSpatialFilter = true;
 		m_OGRLayer->GetExtent(&m_Env);
+		m_bMaterialized = true;
+		if (!m_bReopen) {	// Connexion (base de donnees, service) : la selection a besoin d'un dataset prive
+			GDALDataset* poOther = GDALDataset::Open(m_Source.c_str(), GDAL_OF_VECTOR | GDAL_OF_READONLY);
+			m_bReopen = (poOther != nullptr);
+			if (poOther != nullptr)
+				GDALClose(poOther);
+		}
 		return true;
 	}
+	if (m_OGRLayer->GetGeomType() == wkbNone)	// Layer non geometrique
+		return false;
 	
+	// Index deja calcule lors d'une ouverture precedente
+	m_IndexFile = SpatialIndex::IndexFilename(indexFolder, m_Source, id);
+	if (m_Index.Load(m_IndexFile, m_Source)) {
+		m_Env = m_Index.Bounds();
+		m_FilterRect = m_Env;
+		m_Index.Start(m_FilterRect);
+		m_bMaterialized = true;
+		return true;
+	}
+	// Emprise declaree, si le driver la connait sans lire les features
+	if (m_OGRLayer->GetExtent(&m_Env, FALSE) != OGRERR_NONE)
+		m_Env = OGREnvelope();
+	return true;
+}
+
+//==============================================================================
+// Construction de l'index du layer, s'il n'est pas deja fait, depuis le thread de
+// chargement (IndexLayers) : le layer n'est ni dessine ni selectionne avant la fin.
+// Le verrou du dataset n'est pris que par lots de features, le dessin des autres
+// layers du dataset continue. Ne doit pas etre appele en tenant le verrou du dataset
+// Renvoie false si la lecture a echoue ou a ete interrompue : un nouvel appel
+// recommence la lecture depuis le debut
+//==============================================================================
+bool GeoBase::VectorLayer::Materialize(GDALProgressFunc progress, void* progressData)
+{
+	if (m_bMaterialized)
+		return true;
+	std::lock_guard<std::mutex> indexLock(m_IndexMutex);
+	if (m_bMaterialized)	// Construit par un autre thread pendant l'attente
+		return true;
+	if (m_OGRLayer == nullptr)
+		return false;
+
+	// Lecture des enveloppes, en parallele si le driver le permet
+	std::vector<OGREnvelope> T;
+	std::vector<GIntBig> fid;
+	bool cancelled = false;
+	if (!ReadEnvelopesParallel(m_Source, m_nLayerIndex, T, fid, progress, progressData, cancelled)) {
+		if (cancelled)
+			return false;
+		if (!ReadEnvelopes(T, fid, progress, progressData))
+			return false;
+	}
+	OGREnvelope env;
+	for (size_t i = 0; i < T.size(); i++)
+		env.Merge(T[i]);
+	m_Index.Build(T, fid);
+	m_Index.Save(m_IndexFile, m_Source);
+	std::lock_guard<std::mutex> lock(Mutex());
+	m_Env = env;
+	if (!m_FilterRect.IsInit())
+		m_FilterRect = m_Env;
+	m_Index.Start(m_FilterRect);
+	m_bMaterialized = true;
+	return true;
+}
+
+//==============================================================================
+// Lecture sequentielle des enveloppes : la progression recoit le nombre de features lus
+// Un dataset du pool est lu s'il y en a un ; sinon le dataset partage est verrouille
+// par lots de 1000 features
+//==============================================================================
+bool GeoBase::VectorLayer::ReadEnvelopes(std::vector<OGREnvelope>& T, std::vector<GIntBig>& fid, GDALProgressFunc progress, void* progressData)
+{
+	Reader reader(this, Reader::None);
+	OGRLayer* poLayer = reader.Layer();
+	std::unique_lock<std::mutex> lock(Mutex(), std::defer_lock);
+	if (poLayer == nullptr) {
+		lock.lock();
+		poLayer = m_OGRLayer;
+	}
 	OGREnvelope env;
-	m_OGRLayer->ResetReading();
+	GIntBig count = poLayer->GetFeatureCount(FALSE), nbRead = 0;
+	T.clear();
+	fid.clear();
+	poLayer->ResetReading();
+	bool ok = true;
 	do {
-		OGRFeature* poFeature = m_OGRLayer->GetNextFeature();
+		OGRFeature* poFeature = poLayer->GetNextFeature();
 		if (poFeature == nullptr)
 			break;
+		nbRead++;
 		const OGRGeometry* poGeom = poFeature->GetGeometryRef();
-		poGeom->getEnvelope(&env);
-		m_T.push_back(Feature(poFeature->GetFID(), env, id));
+		if (poGeom != nullptr) {
+			poGeom->getEnvelope(&env);
+			T.push_back(env);
+			fid.push_back(poFeature->GetFID());
+		}
 		OGRFeature::DestroyFeature(poFeature);
-		m_Env.Merge(env);
-	} while (true);
-	if (m_T.size() < 1)
+		if (nbRead % 1000 != 0)
+			continue;
+		bool shared = lock.owns_lock();
+		if (shared)	// Les autres layers du dataset peuvent etre lus
+			lock.unlock();
+		if (progress != nullptr) {
+			double complete = (count > 0) ? std::min(1., (double)nbRead / (double)count) : 0.;
+			ok = (progress(complete, std::to_string(nbRead).c_str(), progressData) != FALSE);
+		}
+		if (shared)
+			lock.lock();
+	} while (ok);
+	poLayer->ResetReading();
+	return ok;
+}
+
+//==============================================================================
+// Lecture parallele des enveloppes par plages de FID : chaque job ouvre son propre
+// dataset et se positionne avec SetNextByIndex. La lecture n'est possible que si le
+// positionnement est rapide et si les FID sont les indices des features (fichiers
+// shape sans .qix par exemple). Les jobs ont leur propre pool : les selections
+// (ForEachLayer) n'attendent pas la fin d'une lecture.
+// Renvoie false si la lecture parallele n'a pas ete faite (ou a ete interrompue)
+//==============================================================================
+bool GeoBase::VectorLayer::ReadEnvelopesParallel(const std::string& source, int id, std::vector<OGREnvelope>& T, std::vector<GIntBig>& fid,
+																								GDALProgressFunc progress, void* progressData, bool& cancelled)
+{
+	const GIntBig minCount = 100000;	// En dessous, l'ouverture des datasets coute plus que la lecture
+	cancelled = false;
+	if (!m_bPooled)	// Chaque thread doit pouvoir rouvrir la source sans charger tout le fichier
+		return false;
+	GIntBig count = 0;
+	{
+		std::lock_guard<std::mutex> lock(Mutex());
+		if ((!m_OGRLayer->TestCapability(OLCFastSetNextByIndex)) || (!m_OGRLayer->TestCapability(OLCRandomRead)))
+			return false;
+		count = m_OGRLayer->GetFeatureCount(FALSE);
+	}
+	if (count < minCount)
 		return false;
-	m_FilterRect = m_Env;
+	int nbThread = (int)std::min<GIntBig>(juce::jmax(1, juce::SystemStats::getNumCpus()), count / (minCount / 4));
+	nbThread = std::min(nbThread, 16);
+	if (nbThread < 2)
+		return false;
+
+	std::vector<std::vector<OGREnvelope> > threadT(nbThread);
+	std::vector<std::vector<GIntBig> > threadFid(nbThread);
+	std::vector<char> threadOk(nbThread, 0);
+	std::atomic<GIntBig> nbRead(0);
+	std::atomic<int> nbFinished(0);
+	std::atomic<bool> stop(false);
+	juce::ThreadPool pool(nbThread);
+	for (int k = 0; k < nbThread; k++) {
+		GIntBig start = count * k / nbThread, end = count * (k + 1) / nbThread;
+		pool.addJob([&, k, start, end]() {
+			GDALDataset* poDataset = GDALDataset::Open(source.c_str(), GDAL_OF_VECTOR | GDAL_OF_READONLY);
+			OGRLayer* poLayer = (poDataset != nullptr) ? poDataset->GetLayer(id) : nullptr;
+			if ((poLayer != nullptr) && (poLayer->SetNextByIndex(start) == OGRERR_NONE)) {
+				OGREnvelope env;
+				GIntBig i = start;
+				threadT[k].reserve((size_t)(end - start));
+				threadFid[k].reserve((size_t)(end - start));
+				for (; (i < end) && (!stop); i++) {
+					OGRFeature* poFeature = poLayer->GetNextFeature();
+					if (poFeature == nullptr)
+						break;
+					if (poFeature->GetFID() != i) {	// Features supprimes : les plages ne sont plus fiables
+						OGRFeature::DestroyFeature(poFeature);
+						break;
+					}
+					const OGRGeometry* poGeom = poFeature->GetGeometryRef();
+					if (poGeom != nullptr) {
+						poGeom->getEnvelope(&env);
+						threadT[k].push_back(env);
+						threadFid[k].push_back(i);
+					}
+					OGRFeature::DestroyFeature(poFeature);
+					if ((i - start) % 1000 == 999)
+						nbRead += 1000;
+				}
+				threadOk[k] = (i == end) ? 1 : 0;
+			}
+			if (poDataset != nullptr)
+				poDataset->Release();
+			if (!threadOk[k])
+				stop = true;
+			nbFinished++;
+		});
+	}
+	// La progression GDAL n'est appelee que depuis ce thread
+	while (nbFinished < nbThread) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if ((progress != nullptr) && (!stop)) {
+			GIntBig n = nbRead;
+			if (!progress(std::min(1., (double)n / (double)count), std::to_string(n).c_str(), progressData)) {
+				cancelled = true;
+				stop = true;
+			}
+		}
+	}
+	for (int k = 0; k < nbThread; k++)
+		if (!threadOk[k])
+			return false;
+
+	T.clear();
+	fid.clear();
+	for (int k = 0; k < nbThread; k++) {
+		T.insert(T.end(), threadT[k].begin(), threadT[k].end());
+		fid.insert(fid.end(), threadFid[k].begin(), threadFid[k].end());
+	}
 	return true;
 }
 
+//==============================================================================
+// Drivers dont les fichiers peuvent etre ouverts par chaque thread : les features
+// sont lus a la demande. Les autres (GeoJSON, CSV, KML...) chargent tout le
+// fichier a l'ouverture
+//==============================================================================
+bool GeoBase::VectorLayer::ReopenableDriver(GDALDataset* poDataset)
+{
+	static const char* drivers[] = { "ESRI Shapefile", "GPKG", "SQLite", "FlatGeobuf", "OpenFileGDB", "FileGDB",
+																	 "MapInfo File", "Parquet", "Arrow" };
+	if ((poDataset == nullptr) || (poDataset->GetDriver() == nullptr))
+		return false;
+	std::string driver = poDataset->GetDriver()->GetDescription();
+	for (size_t i = 0; i < sizeof(drivers) / sizeof(drivers[0]); i++)
+		if (driver == drivers[i])
+			return true;
+	return false;
+}
+
+//==============================================================================
+// Reader : emprunt d'un dataset pour le thread appelant
+//==============================================================================
+GeoBase::VectorLayer::Reader::Reader(VectorLayer* layer, Fallback fallback)
+{
+	m_Layer = nullptr;
+	m_Private = nullptr;
+	if (layer->m_bPooled) {
+		m_Lease = DatasetPool::Instance().Acquire(layer->m_Source, GDAL_OF_VECTOR | GDAL_OF_READONLY);
+		if (m_Lease.Dataset() != nullptr)
+			m_Layer = m_Lease.Dataset()->GetLayer(layer->m_nLayerIndex);
+		if (m_Layer != nullptr)
+			return;
+		m_Lease.Release();
+	}
+	if (fallback == None)
+		return;
+	if ((fallback == Private) && (layer->m_bReopen)) {
+		m_Private = GDALDataset::Open(layer->m_Source.c_str(), GDAL_OF_VECTOR | GDAL_OF_READONLY);
+		if (m_Private != nullptr)
+			m_Layer = m_Private->GetLayer(layer->m_nLayerIndex);
+		if (m_Layer != nullptr)
+			return;
+		if (m_Private != nullptr)
+			GDALClose(m_Private);
+		m_Private = nullptr;
+	}
+	m_Lock = std::unique_lock<std::mutex>(layer->Mutex());
+	m_Layer = layer->m_OGRLayer;
+}
+
 //==============================================================================
 // Fixe l'enveloppe pour la recherche de feature
 //==============================================================================
@@ -359,7 +1210,7 @@ void GeoBase::VectorLayer::SetSpatialFilterRect(const OGREnvelope& env, OGRSpati
 		return;
 	m_FilterRect = GeoBase::ConvertEnvelop(env, spatialRef, m_OGRLayer->GetSpatialRef());
 	m_OGRLayer->SetSpatialFilterRect(m_FilterRect.MinX, m_FilterRect.MinY, m_FilterRect.MaxX, m_FilterRect.MaxY);
-	m_nIndex = 0;
+	m_Index.Start(m_FilterRect);
 }
 
 //==============================================================================
@@ -371,12 +1222,9 @@ OGRFeature* GeoBase::VectorLayer::GetNextFeature()
 		return nullptr;
 	if (m_bFastSpatialFilter)
 		return m_OGRLayer->GetNextFeature();
-	for (size_t i = m_nIndex; i < m_T.size(); i++) {
-		if (!m_T[i].Intersect(m_FilterRect))
-			continue;
-		m_nIndex = i + 1;
-		return m_OGRLayer->GetFeature(m_T[i].Id());
-	}
+	size_t i;
+	if (m_Index.Next(i))
+		return m_OGRLayer->GetFeature(m_Index.Fid(i));
 	return nullptr;
 }
 
@@ -397,15 +1245,281 @@ bool GeoBase::VectorLayer::GetNextFeatureId(GIntBig& id, OGREnvelope& env)
 		OGRFeature::DestroyFeature(poFeature);
 		return true;
 	}
-	for (size_t i = m_nIndex; i < m_T.size(); i++) {
-		if (!m_T[i].Intersect(m_FilterRect))
-			continue;
-		m_nIndex = i + 1;
-		id = m_T[i].Id();
-		env = m_T[i].Envelope();
-		return true;
+	size_t i;
+	if (!(m_bNearest ? m_Index.NextNearest(i) : m_Index.Next(i)))
+		return false;
+	id = m_Index.Fid(i);
+	env = m_Index.Envelope(i);
+	return true;
+}
+
+//==============================================================================
+// Lecture des features par distance croissante a un point
+//==============================================================================
+void GeoBase::VectorLayer::ResetReadingFrom(double x, double y)
+{
+	ResetReading();
+	if (m_bFastSpatialFilter)
+		return;
+	m_bNearest = true;
+	m_Index.StartNearest(m_FilterRect, x, y);
+}
+
+//==============================================================================
+// Selection des features intersectant une enveloppe (dans le systeme spatialRef)
+// 1) les candidats sont lus dans l'index, 2) les features dont l'enveloppe est
+// dans le rectangle sont acceptes, 3) GEOS ne teste que les features en bordure
+//==============================================================================
+void GeoBase::VectorLayer::SelectFeatures(const OGREnvelope& env, OGRSpatialReference* spatialRef, std::vector<Feature>& selection)
+{
+	if (!Materialized())	// Index construit au premier dessin, pas depuis le thread des messages
+		return;
+	Reader reader(this, m_bFastSpatialFilter ? Reader::Private : Reader::Shared);
+	OGRLayer* poLayer = reader.Layer();
+	if (poLayer == nullptr)
+		return;
+	OGRLinearRing ring;
+	OGRPolygon poly;
+	ring.addPoint(env.MinX, env.MinY);
+	ring.addPoint(env.MaxX, env.MinY);
+	ring.addPoint(env.MaxX, env.MaxY);
+	ring.addPoint(env.MinX, env.MaxY);
+	ring.addPoint(env.MinX, env.MinY);
+	ring.closeRings();
+	poly.addRing(&ring);
+	if (!poly.IsValid())
+		return;
+	Transformation* transfo = Transformation::Get(spatialRef, poLayer->GetSpatialRef());
+	if (transfo == nullptr)
+		return;
+	OGREnvelope inner = transfo->InnerEnvelope(env);
+	transfo->Transform(&poly);
+	OGREnvelope outer;
+	poly.getEnvelope(&outer);
+
+	OGREnvelope featureEnv;
+	if (!m_bFastSpatialFilter) {
+		std::vector<size_t> items;
+		std::vector<GIntBig> border;
+		m_Index.Search(outer, items);
+		for (size_t i = 0; i < items.size(); i++) {
+			if (inner.Contains(m_Index.Envelope(items[i])))
+				selection.push_back(Feature(m_Index.Fid(items[i]), m_Index.Envelope(items[i]), m_Id));
+			else
+				border.push_back(m_Index.Fid(items[i]));
+		}
+		for (size_t i = 0; i < border.size(); i++) {
+			OGRFeature* poFeature = poLayer->GetFeature(border[i]);
+			if (poFeature == nullptr)
+				continue;
+			OGRGeometry* poGeom = poFeature->GetGeometryRef();
+			if ((poGeom != nullptr) && (poGeom->Intersects(&poly) == TRUE)) {
+				poGeom->getEnvelope(&featureEnv);
+				selection.push_back(Feature(border[i], featureEnv, m_Id));
+			}
+			OGRFeature::DestroyFeature(poFeature);
+		}
+		return;
+	}
+
+	// Index du driver : le filtre est pose sur un dataset propre a la selection ; si le dataset
+	// partage est utilise (SharedSelection), le thread de dessin a ete arrete. Le filtre du dessin est remis en place a la fin
+	poLayer->SetSpatialFilterRect(outer.MinX, outer.MinY, outer.MaxX, outer.MaxY);
+	poLayer->ResetReading();
+	do {
+		OGRFeature* poFeature = poLayer->GetNextFeature();
+		if (poFeature == nullptr)
+			break;
+		OGRGeometry* poGeom = poFeature->GetGeometryRef();
+		GIntBig featureId = poFeature->GetFID();
+		if ((poGeom != nullptr) && (featureId != OGRNullFID)) {
+			poGeom->getEnvelope(&featureEnv);
+			if ((inner.Contains(featureEnv)) || (poGeom->Intersects(&poly) == TRUE))
+				selection.push_back(Feature(featureId, featureEnv, m_Id));
+		}
+		OGRFeature::DestroyFeature(poFeature);
+	} while (true);
+	poLayer->SetSpatialFilterRect(m_FilterRect.MinX, m_FilterRect.MinY, m_FilterRect.MaxX, m_FilterRect.MaxY);
+	poLayer->ResetReading();
+}
+
+//==============================================================================
+// Champs d'un layer
+//==============================================================================
+int GeoBase::VectorLayer::GetFieldCount()
+{
+	if (m_OGRLayer == nullptr)
+		return 0;
+	return m_OGRLayer->GetLayerDefn()->GetFieldCount();
+}
+
+std::string GeoBase::VectorLayer::GetFieldName(int i)
+{
+	if ((m_OGRLayer == nullptr) || (i < 0) || (i >= GetFieldCount()))
+		return "";
+	return m_OGRLayer->GetLayerDefn()->GetFieldDefn(i)->GetNameRef();
+}
+
+//==============================================================================
+// Valeur d'un champ pour l'affichage : les binaires ne sont pas convertis et
+// les textes longs sont tronques
+//==============================================================================
+static std::string FieldValueText(OGRFeature* poFeature, int i)
+{
+	const size_t maxLength = 1024;
+	if (!poFeature->IsFieldSet(i))
+		return "";
+	if (poFeature->GetFieldDefnRef(i)->GetType() == OFTBinary) {
+		int nbByte = 0;
+		poFeature->GetFieldAsBinary(i, &nbByte);
+		return "<" + std::to_string(nbByte) + " bytes>";
+	}
+	std::string value = poFeature->GetFieldAsString(i);
+	if (value.size() > maxLength)
+		value = value.substr(0, maxLength) + "...";
+	return value;
+}
+
+//==============================================================================
+// Valeur d'un champ d'un feature
+// Les champs sont lus par pages : seules les colonnes de la page sont demandees
+// a OGR (les autres champs et la geometrie sont ignores), puis mises en cache
+//==============================================================================
+std::string GeoBase::VectorLayer::GetFieldValue(GIntBig id, int i)
+{
+	const int pageSize = 32;
+	std::string value;
+	{
+		std::lock_guard<std::mutex> lock(m_AttributesMutex);
+		if (m_Attributes.Find(id, i, value))
+			return value;
+	}
+	int nbField = GetFieldCount();
+	if ((i < 0) || (i >= nbField) || (id == OGRNullFID))
+		return "";
+	Reader reader(this);
+	OGRLayer* poLayer = reader.Layer();
+	if (poLayer == nullptr)
+		return "";
+	int first = (i / pageSize) * pageSize, last = std::min(nbField, first + pageSize);
+
+	OGRFeatureDefn* poDefn = poLayer->GetLayerDefn();
+	bool ignore = (poLayer->TestCapability(OLCIgnoreFields) == TRUE);
+	if (ignore) {
+		std::vector<const char*> ignored;
+		for (int k = 0; k < nbField; k++)
+			if ((k < first) || (k >= last))
+				ignored.push_back(poDefn->GetFieldDefn(k)->GetNameRef());
+		ignored.push_back("OGR_GEOMETRY");
+		ignored.push_back("OGR_STYLE");
+		ignored.push_back(nullptr);
+		if (poLayer->SetIgnoredFields(ignored.data()) != OGRERR_NONE)
+			ignore = false;
+	}
+	OGRFeature* poFeature = poLayer->GetFeature(id);
+	if (ignore)
+		poLayer->SetIgnoredFields(nullptr);
+	if (poFeature == nullptr)
+		return "";
+	{
+		std::lock_guard<std::mutex> lock(m_AttributesMutex);
+		for (int k = first; k < last; k++)
+			m_Attributes.Insert(id, nbField, k, FieldValueText(poFeature, k));
+	}
+	value = FieldValueText(poFeature, i);
+	OGRFeature::DestroyFeature(poFeature);
+	return value;
+}
+
+//==============================================================================
+// Selection des k features les plus proches d'un point (dans le systeme spatialRef)
+// La distance est calculee sur la geometrie reelle ; l'index ne lit que les
+// features dont l'enveloppe est plus proche que les meilleurs candidats
+// Les distances du layer sont ramenees au systeme spatialRef par le rapport des tolerances
+//==============================================================================
+void GeoBase::VectorLayer::SelectNearestFeatures(double x, double y, double tolerance, double bound, OGRSpatialReference* spatialRef, size_t k,
+																								 std::vector<std::pair<double, Feature> >& selection)
+{
+	if (!Materialized())	// Index construit au premier dessin, pas depuis le thread des messages
+		return;
+	if ((k < 1) || (tolerance <= 0.) || (bound < 0.))
+		return;
+	Reader reader(this, m_bFastSpatialFilter ? Reader::Private : Reader::Shared);
+	OGRLayer* poLayer = reader.Layer();
+	if (poLayer == nullptr)
+		return;
+	Transformation* transfo = Transformation::Get(spatialRef, poLayer->GetSpatialRef());
+	if (transfo == nullptr)
+		return;
+	// Tolerance dans le systeme du layer
+	OGREnvelope env;
+	env.MinX = x - tolerance; env.MaxX = x + tolerance;
+	env.MinY = y - tolerance; env.MaxY = y + tolerance;
+	OGREnvelope box = transfo->Transform(env);
+	if (!transfo->Transform(1, &x, &y))
+		return;
+	double scale = std::max(box.MaxX - box.MinX, box.MaxY - box.MinY) * 0.5 / tolerance;	// Unites du layer par unite de spatialRef
+	if (scale <= 0.)
+		return;
+	double maxDist = std::min(bound, tolerance) * scale;
+	OGRPoint point(x, y);
+
+	std::vector<std::pair<double, size_t> > items;
+	std::vector<OGREnvelope> featureEnv;
+	if (!m_bFastSpatialFilter) {
+		auto distance = [&](size_t i) -> double {
+			const OGREnvelope& e = m_Index.Envelope(i);
+			if ((e.MinX == e.MaxX) && (e.MinY == e.MaxY))	// Point : l'enveloppe suffit
+				return SpatialIndex::Distance(e, x, y);
+			OGRFeature* poFeature = poLayer->GetFeature(m_Index.Fid(i));
+			if (poFeature == nullptr)
+				return -1.;
+			OGRGeometry* poGeom = poFeature->GetGeometryRef();
+			double d = (poGeom != nullptr) ? poGeom->Distance(&point) : -1.;
+			OGRFeature::DestroyFeature(poFeature);
+			return d;
+		};
+		m_Index.Nearest(x, y, maxDist, k, distance, items);
+		for (size_t i = 0; i < items.size(); i++)	// Avec les ex-aequo du k-ieme
+			selection.push_back(std::pair<double, Feature>(items[i].first / scale,
+				Feature(m_Index.Fid(items[i].second), m_Index.Envelope(items[i].second), m_Id)));
+		return;
+	}
+
+	// Index du driver, sur un dataset propre a la selection (sinon le dessin est arrete, voir SharedSelection) :
+	// les candidats sont tries par distance, le filtre du dessin est remis en place a la fin
+	std::vector<GIntBig> fid;
+	OGREnvelope searchEnv;
+	searchEnv.MinX = x - maxDist; searchEnv.MaxX = x + maxDist;
+	searchEnv.MinY = y - maxDist; searchEnv.MaxY = y + maxDist;
+	poLayer->SetSpatialFilterRect(searchEnv.MinX, searchEnv.MinY, searchEnv.MaxX, searchEnv.MaxY);
+	poLayer->ResetReading();
+	do {
+		OGRFeature* poFeature = poLayer->GetNextFeature();
+		if (poFeature == nullptr)
+			break;
+		OGRGeometry* poGeom = poFeature->GetGeometryRef();
+		if ((poGeom != nullptr) && (poFeature->GetFID() != OGRNullFID)) {
+			double d = poGeom->Distance(&point);
+			if ((d >= 0.) && (d <= maxDist)) {
+				OGREnvelope e;
+				poGeom->getEnvelope(&e);
+				items.push_back(std::pair<double, size_t>(d, fid.size()));
+				fid.push_back(poFeature->GetFID());
+				featureEnv.push_back(e);
+			}
+		}
+		OGRFeature::DestroyFeature(poFeature);
+	} while (true);
+	poLayer->SetSpatialFilterRect(m_FilterRect.MinX, m_FilterRect.MinY, m_FilterRect.MaxX, m_FilterRect.MaxY);
+	poLayer->ResetReading();
+	std::sort(items.begin(), items.end());
+	for (size_t i = 0; i < items.size(); i++) {
+		if ((i >= k) && (items[i].first > items[k - 1].first))	// Les ex-aequo du k-ieme sont conserves
+			break;
+		selection.push_back(std::pair<double, Feature>(items[i].first / scale,
+			Feature(fid[items[i].second], featureEnv[items[i].second], m_Id)));
 	}
-	return false;
 }
 
 //==============================================================================
@@ -421,6 +1535,79 @@ bool GeoBase::RasterLayer::AddDataset(GDALDataset* poDataset)
 	return true;
 }
 
+//==============================================================================
+// Ajout d'un raster ouvert a la demande
+//==============================================================================
+bool GeoBase::RasterLayer::AddFile(const char* filename)
+{
+	Raster raster;
+	if (!raster.AddFile(filename))
+		return false;
+	m_Raster.push_back(raster);
+	m_TotalEnv.Merge(raster.Envelope());
+	return true;
+}
+
+//==============================================================================
+// Recherche des rasters intersectant une emprise avec l'index des emprises
+//==============================================================================
+void GeoBase::RasterLayer::Search(const OGREnvelope& env, std::vector<int>& rasters)
+{
+	rasters.clear();
+	if (!env.Intersects(m_TotalEnv))
+		return;
+	if (m_Index.Size() != m_Raster.size()) {	// Rasters ajoutes depuis la derniere construction
+		std::vector<OGREnvelope> footprint(m_Raster.size());
+		std::vector<GIntBig> id(m_Raster.size());
+		for (size_t i = 0; i < m_Raster.size(); i++) {
+			footprint[i] = m_Raster[i].Envelope();
+			id[i] = (GIntBig)i;
+		}
+		m_Index.Build(footprint, id);
+	}
+	std::vector<size_t> items;
+	m_Index.Search(env, items);
+	for (size_t i = 0; i < items.size(); i++)
+		rasters.push_back((int)m_Index.Fid(items[i]));
+	std::sort(rasters.begin(), rasters.end());
+}
+
+bool GeoBase::RasterLayer::ReplaceDataset(GDALDataset* oldDataset, GDALDataset* newDataset)
+{
+	bool flag = false;
+	for (size_t i = 0; i < m_Raster.size(); i++) {
+		if (m_Raster[i].Dataset() == oldDataset) {
+			m_Raster[i].Dataset(newDataset);
+			RasterCache::Instance().Invalidate(&m_Raster[i]);	// Les apercus ont change
+			flag = true;
+		}
+	}
+	return flag;
+}
+
+bool GeoBase::RasterLayer::UpdateOverviews(const std::string& filename, int overviews)
+{
+	bool flag = false;
+	for (size_t i = 0; i < m_Raster.size(); i++) {
+		if ((m_Raster[i].Dataset() == nullptr) && (m_Raster[i].File() == filename)) {
+			m_Raster[i].Overviews(overviews);
+			RasterCache::Instance().Invalidate(&m_Raster[i]);	// Les apercus ont change
+			flag = true;
+		}
+	}
+	return flag;
+}
+
+int GeoBase::RasterLayer::Overviews()
+{
+	if (m_Raster.size() < 1)
+		return 0;
+	int nb = m_Raster[0].Overviews();
+	for (size_t i = 1; i < m_Raster.size(); i++)
+		nb = std::min(nb, m_Raster[i].Overviews());
+	return nb;
+}
+
 double GeoBase::RasterLayer::GSD()
 {
 	double gsd = std::numeric_limits<double>::max();
@@ -456,6 +1643,32 @@ bool GeoBase::Raster::AddDataset(GDALDataset* poDataset)
 	m_Env.Merge(X2, Y2);
 	m_Env.Merge(X3, Y3);
 	m_Dataset = poDataset;
+	m_nOverviews = (poDataset->GetRasterCount() > 0) ? poDataset->GetRasterBand(1)->GetOverviewCount() : 0;
+	VSIStatBufL stat;
+	m_File.clear();
+	if (VSIStatL(poDataset->GetDescription(), &stat) == 0)	// Seuls les fichiers peuvent etre rouverts
+		m_File = poDataset->GetDescription();
 
 	return true;
+}
+
+//==============================================================================
+// Ajout d'un raster ouvert a la demande : le fichier n'est ouvert que le temps
+// de lire sa geometrie
+//==============================================================================
+bool GeoBase::Raster::AddFile(const char* filename)
+{
+	GDALDataset* poDataset = GDALDataset::Open(filename, GDAL_OF_RASTER | GDAL_OF_READONLY);
+	if (poDataset == nullptr)
+		return false;
+	bool flag = AddDataset(poDataset);
+	m_Dataset = nullptr;
+	poDataset->Release();
+	return flag && (!m_File.empty());
+}
+
+void GeoBase::Raster::Dataset(GDALDataset* poDataset)
+{
+	m_Dataset = poDataset;
+	m_nOverviews = (poDataset->GetRasterCount() > 0) ? poDataset->GetRasterBand(1)->GetOverviewCount() : 0;
 }
\ No newline at end of file
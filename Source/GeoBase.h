@@ -6,9 +6,23 @@
 //==============================================================================
 
 #pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "ogrsf_frmts.h"
+#include "cpl_progress.h"
+#include "GeometryCache.h"
+#include "AttributeCache.h"
+#include "SpatialIndex.h"
+#include "DatasetPool.h"
 
 class GDALDataset;
+namespace juce { class ThreadPool; }
 
 class GeoBase {
 public:
@@ -16,20 +30,45 @@ public:
 	class Feature;
 	class RasterLayer;
 	class Raster;
+	class Transformation;
+	class Loading;
 
 	GeoBase();
-	virtual ~GeoBase() { Clear(); }
+	virtual ~GeoBase();
 	void Clear();
 
 	bool OpenVectorDataset(const char* filename, char** options = nullptr);
 	bool OpenRasterDataset(const char* filename, const char* name = nullptr, bool visible = true,
 												 char** options = nullptr, bool dtm = false);
 	bool OpenRasterMultiDataset(const char* filename);
+	// Ouverture en deux temps : lecture hors de la base (thread de chargement), puis ajout en une fois
+	bool LoadVectorDataset(const char* filename, Loading& loading, GDALProgressFunc progress = nullptr, void* progressData = nullptr,
+												 char** options = nullptr);
+	bool LoadRasterDataset(const char* filename, Loading& loading, const char* name = nullptr, bool visible = true,
+												 char** options = nullptr, bool dtm = false);
+	bool LoadRasterFolder(const char* folder, Loading& loading, const char* name = nullptr, GDALProgressFunc progress = nullptr,
+												void* progressData = nullptr, bool dtm = false);
+	bool AddLoading(Loading& loading);
+	// Indexation des layers vecteurs : les layers visibles pas encore indexes sont indexes par le
+	// thread de chargement (IndexLayers), puis leur emprise est ajoutee a celle de la base
+	std::vector<VectorLayer*> UnindexedLayers();
+	static bool IndexLayers(const std::vector<VectorLayer*>& layers, GDALProgressFunc progress = nullptr, void* progressData = nullptr);
+	void HideUnindexedLayers();
+	void UpdateEnvelope();
+	bool ReplaceDataset(GDALDataset* oldDataset, GDALDataset* newDataset);
+	bool UpdateOverviews(const std::string& filename, int overviews);
 	bool IsOpen(const char* filename);
+	GDALDataset* FindDataset(const char* filename);
+	static std::string CanonicalPath(const char* filename);
 	size_t SelectFeatures(const OGREnvelope& env, OGRSpatialReference* spatialRef);
+	size_t SelectNearestFeatures(double x, double y, double tolerance, OGRSpatialReference* spatialRef, size_t k = 1);
 	bool SelectFeatureFields(int layerId, GIntBig featureId);
+	bool SharedSelection();	// Le thread de dessin doit etre arrete avant la selection
 
 	OGRSpatialReference* SpatialRef() { return &m_SpatialRef; }
+	void SetCacheBudget(size_t budget);
+	void SetIndexFolder(const std::string& folder) { m_IndexFolder = folder; }
+	std::string IndexFolder() { return m_IndexFolder; }
 	int GetVectorLayerCount() { return (int)m_VLayers.size(); }
 	VectorLayer* GetVectorLayer(int i) { if (i < m_VLayers.size()) return m_VLayers[i]; return nullptr; }
 	VectorLayer* GetVectorLayerId(int id) { for (int i = 0; i < m_VLayers.size(); i++) if (m_VLayers[i]->Id() == id) return m_VLayers[i]; return nullptr; }
@@ -48,16 +87,40 @@ public:
 	OGREnvelope GetEnvelope() { return m_Env; }
 	size_t GetSelectionCount() { return m_Selection.size(); }
 	Feature GetSelection(size_t index) { return m_Selection[index]; }
-	int GetFieldCount() { return (int)m_Field.size() / 2; }
-	std::string GetFieldName(int i) { if (i < GetFieldCount()) return m_Field[2 * i]; return ""; }
-	std::string GetFieldValue(int i) { if (i < GetFieldCount()) return m_Field[2 * i + 1]; return ""; }
+	// Champs du feature selectionne par SelectFeatureFields : les valeurs sont lues a la demande
+	int GetFieldCount() { return GetFieldCount(m_nFieldLayer); }
+	std::string GetFieldName(int i) { return GetFieldName(m_nFieldLayer, i); }
+	std::string GetFieldValue(int i) { return GetFieldValue(m_nFieldLayer, m_nFieldFeature, i); }
+	int GetFieldCount(int layerId);
+	std::string GetFieldName(int layerId, int i);
+	std::string GetFieldValue(int layerId, GIntBig featureId, int i);
 
 	static OGREnvelope ConvertEnvelop(const OGREnvelope& env, OGRSpatialReference* fromRef, OGRSpatialReference* toRef);
 
+	// Transformation de coordonnees, mise en cache par couple (source, destination) et par thread
+	class Transformation {
+	protected:
+		OGRCoordinateTransformation*	m_Transfo;	// nullptr si les deux systemes sont identiques
+		std::vector<double>						m_X, m_Y, m_Z;
+		std::vector<OGRGeometry*>			m_Parts;
+		bool Collect(OGRGeometry* poGeom);
+	public:
+		Transformation(OGRCoordinateTransformation* poTransfo) { m_Transfo = poTransfo; }
+		virtual ~Transformation() { delete m_Transfo; }
+		static Transformation* Get(OGRSpatialReference* fromRef, OGRSpatialReference* toRef);
+		bool IsIdentity() { return m_Transfo == nullptr; }
+		bool Transform(int n, double* x, double* y);
+		bool Transform(OGRGeometry* poGeom);
+		OGREnvelope Transform(const OGREnvelope& env);
+		OGREnvelope InnerEnvelope(const OGREnvelope& env);
+	};
+
 	typedef struct {
 		GUInt32			PenColor;
 		GUInt32			FillColor;
 		float				PenSize;
+		float				Decimation;	// Tolerance de simplification a l'affichage (pixels), 0 : aucune
+		float				SymbolSize;	// Diametre du symbole des points (pixels)
 		bool				Visible;
 	} Repres;
 
@@ -79,44 +142,126 @@ public:
 	protected:
 		GDALDataset*	m_Dataset;
 		OGRLayer*			m_OGRLayer;
+		std::string		m_Source;				// Fichier du dataset, pour ouvrir un dataset par thread
+		int						m_nLayerIndex;	// Indice du layer dans le dataset
+		bool					m_bPooled;			// Le dataset peut etre ouvert par le pool
+		bool					m_bReopen;			// Le dataset peut etre rouvert (pool ou dataset prive)
+		std::atomic<bool>	m_bMaterialized;	// Index construit (ou inutile : index du driver)
+		std::string		m_IndexFile;		// Fichier de l'index, vide si l'index n'est pas conserve
 		int						m_Id;
 		OGREnvelope		m_Env;
 		bool					m_bFastSpatialFilter;
 		OGREnvelope		m_FilterRect;
-		size_t				m_nIndex;
-		std::vector<Feature> m_T;
+		SpatialIndex	m_Index;				// Enveloppes et FID des features
+		bool					m_bNearest;			// Lecture de l'index par distance croissante
+		std::shared_ptr<std::mutex> m_Mutex;	// Acces au dataset (partage par les layers d'un meme dataset)
+		std::mutex		m_DrawMutex;		// Etat du dessin (index, cache) quand le dataset vient du pool
+		std::mutex		m_IndexMutex;		// Construction de l'index
+		GeometryCache	m_Cache;				// Geometries deja projetees dans le systeme de la vue
+		AttributeCache	m_Attributes;	// Valeurs des attributs deja lues
+		std::mutex		m_AttributesMutex;
+
+		bool ReadEnvelopes(std::vector<OGREnvelope>& T, std::vector<GIntBig>& fid, GDALProgressFunc progress, void* progressData);
+		bool ReadEnvelopesParallel(const std::string& source, int id, std::vector<OGREnvelope>& T, std::vector<GIntBig>& fid,
+															 GDALProgressFunc progress, void* progressData, bool& cancelled);
+		static bool ReopenableDriver(GDALDataset* poDataset);
 	public:
+		// Acces a l'OGRLayer depuis n'importe quel thread, hors dessin : un dataset propre au
+		// thread est emprunte au pool ; a defaut, le dataset partage est verrouille
+		// Private : un dataset est ouvert pour ce seul Reader avant de se rabattre sur le dataset partage
+		// None : pas de repli, Layer() est nul si le pool ne fournit pas de dataset
+		// L'etat de lecture (filtre, champs ignores) doit etre remis en place avant la destruction
+		class Reader {
+		public:
+			typedef enum { Shared = 0, Private = 1, None = 2 } Fallback;
+			Reader(VectorLayer* layer, Fallback fallback = Shared);
+			virtual ~Reader() { if (m_Private != nullptr) GDALClose(m_Private); }
+			OGRLayer* Layer() { return m_Layer; }
+			bool IsShared() { return m_Lock.owns_lock(); }
+		private:
+			DatasetPool::Lease						m_Lease;
+			GDALDataset*									m_Private;
+			std::unique_lock<std::mutex>	m_Lock;
+			OGRLayer*											m_Layer;
+		};
+
 		VectorLayer(int id);
 		inline int Id() { return m_Id; }
-		bool SetDataset(GDALDataset* poDataset, int id);
+		void SetId(int id) { m_Id = id; }
+		bool SetDataset(GDALDataset* poDataset, int id, std::shared_ptr<std::mutex> mutex = nullptr, const std::string& indexFolder = "");
+		bool Materialize(GDALProgressFunc progress = nullptr, void* progressData = nullptr);
+		bool Materialized() { return m_bMaterialized; }
+		std::mutex& Mutex() { return *m_Mutex; }
+		std::mutex& DrawMutex() { return m_DrawMutex; }
 		OGREnvelope Envelope() { return m_Env; }
 		OGRSpatialReference* SpatialRef() { if (m_OGRLayer != nullptr) return m_OGRLayer->GetSpatialRef(); return nullptr; }
 		GIntBig GetFeatureCount() { if (m_OGRLayer != nullptr) return m_OGRLayer->GetFeatureCount(); return 0; }
 		void SetSpatialFilterRect(const OGREnvelope& env, OGRSpatialReference* spatialRef);
-		void ResetReading() { if (m_OGRLayer != nullptr) m_OGRLayer->ResetReading(); m_nIndex = 0; }
+		void ResetReading() { if (m_OGRLayer != nullptr) m_OGRLayer->ResetReading(); ResetIndex(); }
+		void ResetIndex() { m_bNearest = false; m_Index.Start(m_FilterRect); }	// Sans toucher au dataset partage
+		const OGREnvelope& FilterRect() { return m_FilterRect; }	// Systeme du layer
+		// Lecture des features du filtre du plus proche au plus eloigne de (x, y), dans le systeme du layer
+		// Sans index (FastSpatialFilter), les features sont lus dans l'ordre du dataset
+		void ResetReadingFrom(double x, double y);
 		OGRFeature* GetNextFeature();
 		bool GetNextFeatureId(GIntBig& id, OGREnvelope& env);
+		void SelectFeatures(const OGREnvelope& env, OGRSpatialReference* spatialRef, std::vector<Feature>& selection);
+		// bound : distance maximale (<= tolerance) ; les distances renvoyees sont dans le systeme spatialRef
+		void SelectNearestFeatures(double x, double y, double tolerance, double bound, OGRSpatialReference* spatialRef, size_t k,
+															 std::vector<std::pair<double, Feature> >& selection);
 		OGRLayer* GetOGRLayer() { return m_OGRLayer; }
+		bool FastSpatialFilter() { return m_bFastSpatialFilter; }
+		// La selection lit le dataset partage : elle ne peut pas se faire pendant le dessin du layer
+		bool SharedSelection() { return m_bFastSpatialFilter && (!m_bReopen); }
+		GeometryCache* Cache() { return &m_Cache; }
+		int GetFieldCount();
+		std::string GetFieldName(int i);
+		std::string GetFieldValue(GIntBig id, int i);
 
 		Repres				m_Repres;
 	};
 
+	// Dataset ouvert et indexe, pas encore ajoute a la base
+	class Loading {
+	public:
+		GDALDataset*							Dataset;
+		std::vector<VectorLayer*>	VLayers;
+		RasterLayer*							RLayer;
+		bool											Dtm;
+		std::vector<std::string>	Files;		// Fichiers du dataset, chemins canoniques
+		Loading() { Dataset = nullptr; RLayer = nullptr; Dtm = false; }
+		virtual ~Loading() { Clear(); }
+		void Clear();
+		void Release() { Dataset = nullptr; VLayers.clear(); RLayer = nullptr; Files.clear(); }	// Les objets appartiennent a la base
+		void ListFiles(const char* filename);
+	};
+
+	// Raster : dataset d'un layer raster. Un raster ouvert a la demande n'a pas de dataset :
+	// seuls son fichier et sa geometrie sont conserves, il est lu avec un dataset du DatasetPool
 	class Raster {
 	protected:
 		GDALDataset*		m_Dataset;
 		OGREnvelope			m_Env;
 		double					m_GSD;
+		int							m_nOverviews;	// Nombre d'apercus, lu a l'ouverture
+		std::string			m_File;				// Fichier pouvant etre rouvert par un autre thread (vide sinon)
 	public:
-		Raster() { m_Dataset = nullptr; m_GSD = 0.; }
+		Raster() { m_Dataset = nullptr; m_GSD = 0.; m_nOverviews = 0; }
 		bool AddDataset(GDALDataset* poDataset);
+		bool AddFile(const char* filename);	// Raster ouvert a la demande
 		OGREnvelope Envelope() { return m_Env; }
 		GDALDataset* Dataset() { return m_Dataset; }
+		void Dataset(GDALDataset* poDataset);	// Meme fichier, rouvert
+		int Overviews() { return m_nOverviews; }
+		void Overviews(int nb) { m_nOverviews = nb; }	// Apercus calcules depuis l'ouverture
+		std::string File() { return m_File; }
 		double GSD() { return m_GSD; }
 	};
 
 	class RasterLayer {
 	protected:
 		std::vector<Raster>			m_Raster;
+		SpatialIndex						m_Index;	// Emprises des rasters, construit a la premiere recherche
 		OGREnvelope							m_TotalEnv;
 		std::string							m_Name;
 		float										m_Opacity;
@@ -128,9 +273,15 @@ public:
 		float Opacity() { return m_Opacity; }
 		void Opacity(float opa) { m_Opacity = opa;  if (opa < 0.) m_Opacity = 0; if (opa > 1.) m_Opacity = 1.;}
 		bool AddDataset(GDALDataset* poDataset);
+		bool AddFile(const char* filename);
 		int GetRasterCount() { return (int)m_Raster.size(); }
+		Raster* GetRaster(int i) { if (i < m_Raster.size()) return &m_Raster[i]; return nullptr; }
 		GDALDataset* GetRasterDataset(int i) { if (i < m_Raster.size()) return m_Raster[i].Dataset(); return nullptr; }
+		bool ReplaceDataset(GDALDataset* oldDataset, GDALDataset* newDataset);
+		bool UpdateOverviews(const std::string& filename, int overviews);
 		OGREnvelope GetRasterEnvelope(int i) { if (i < m_Raster.size()) return m_Raster[i].Envelope(); return OGREnvelope(); }
+		void Search(const OGREnvelope& env, std::vector<int>& rasters);	// Rasters intersectant env, dans l'ordre du layer
+		int Overviews();	// Plus petit nombre d'apercus des datasets
 		double GSD();
 
 		bool				Visible;
@@ -140,11 +291,18 @@ protected:
 	OGRSpatialReference				m_SpatialRef;
 	OGREnvelope								m_Env;
 	std::vector<GDALDataset*> m_Dataset;		// All the datasets
+	std::unordered_map<std::string, GDALDataset*> m_File;	// Files of the datasets (canonical paths)
 	std::vector<VectorLayer*>	m_VLayers;		// Vector layers
 	std::vector<RasterLayer*>	m_RLayers;		// Raster layers
 	std::vector<RasterLayer*>	m_ZLayers;		// DTM layers
 	std::vector<Feature>			m_Selection;	// Selected features
-	std::vector<std::string>	m_Field;			// Fields of the selected feature
+	int												m_nFieldLayer;	// Layer of the selected feature
+	GIntBig										m_nFieldFeature;	// Selected feature
+	size_t										m_nCacheBudget;	// Memory budget of the geometry cache of each vector layer
+	std::string								m_IndexFolder;	// Folder of the spatial index files (empty : no index file)
+	std::unique_ptr<juce::ThreadPool>	m_Pool;	// Threads of the layer queries
 
+	std::vector<VectorLayer*> VisibleVectorLayers();
+	void ForEachLayer(size_t nbLayer, const std::function<void(size_t)>& job);
 	template<typename T> static bool ReorderLayer(std::vector<T*>* V, int oldPosition, int newPosition);
 };
\ No newline at end of file
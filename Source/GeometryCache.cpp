@@ -0,0 +1,149 @@
+//==============================================================================
+// GeometryCache.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "GeometryCache.h"
+
+//==============================================================================
+// FlatGeometry : remise a zero
+//==============================================================================
+void FlatGeometry::Clear()
+{
+	Env = OGREnvelope();
+	Dimension = 0;
+	Fill = false;
+	Pt.clear();
+	Parts.clear();
+	Types.clear();
+	Parts.push_back(0);
+}
+
+//==============================================================================
+// FlatGeometry : memoire occupee, en comptant le noeud du cache
+//==============================================================================
+size_t FlatGeometry::Size() const
+{
+	return sizeof(FlatGeometry) + 64 + Pt.capacity() * sizeof(double) + Parts.capacity() * sizeof(int) + Types.capacity();
+}
+
+//==============================================================================
+// FlatGeometry : copie d'une geometrie OGR (memes types que VectorRenderer::DrawGeometry)
+//==============================================================================
+bool FlatGeometry::Set(const OGRGeometry* poGeom)
+{
+	Clear();
+	if (poGeom == nullptr)
+		return false;
+	poGeom->getEnvelope(&Env);
+	Dimension = poGeom->getDimension();
+	AddPart(poGeom);
+	return (Types.size() > 0);
+}
+
+void FlatGeometry::AddPart(const OGRGeometry* poGeom)
+{
+	switch (wkbFlatten(poGeom->getGeometryType())) {
+	case wkbPoint: {
+		const OGRPoint* poPoint = poGeom->toPoint();
+		if (poPoint->IsEmpty())
+			return;
+		Pt.push_back(poPoint->getX());
+		Pt.push_back(poPoint->getY());
+		Types.push_back(Point);
+		Parts.push_back((int)Pt.size() / 2);
+		return;
+	}
+	case wkbLineString:
+		if (strcmp(poGeom->getGeometryName(), "LINEARRING") == 0)
+			return AddCurve(poGeom->toSimpleCurve(), Ring);
+		return AddCurve(poGeom->toSimpleCurve(), Line);
+	case wkbPolygon: {
+		Fill = true;
+		const OGRPolygon* poPolygon = poGeom->toPolygon();
+		if (poPolygon->getExteriorRingCurve() == nullptr)
+			return;
+		AddPart(poPolygon->getExteriorRingCurve());
+		for (int i = 0; i < poPolygon->getNumInteriorRings(); i++)
+			AddPart(poPolygon->getInteriorRingCurve(i));
+		return;
+	}
+	case wkbMultiPolygon:
+	case wkbMultiLineString:
+	case wkbMultiPoint: {
+		const OGRGeometryCollection* poCollection = poGeom->toGeometryCollection();
+		for (int i = 0; i < poCollection->getNumGeometries(); i++)
+			AddPart(poCollection->getGeometryRef(i));
+		return;
+	}
+	default:
+		return;
+	}
+}
+
+void FlatGeometry::AddCurve(const OGRSimpleCurve* poCurve, PartType type)
+{
+	int n = poCurve->getNumPoints();
+	if (n < 1)
+		return;
+	size_t start = Pt.size();
+	Pt.resize(start + 2 * n);
+	poCurve->getPoints(&Pt[start], 2 * sizeof(double), &Pt[start + 1], 2 * sizeof(double));
+	Types.push_back((unsigned char)type);
+	Parts.push_back((int)Pt.size() / 2);
+}
+
+//==============================================================================
+// GeometryCache : recherche d'une geometrie, qui devient la plus recente
+//==============================================================================
+const FlatGeometry* GeometryCache::Find(GIntBig id)
+{
+	auto iter = m_Map.find(id);
+	if (iter == m_Map.end())
+		return nullptr;
+	m_List.splice(m_List.begin(), m_List, iter->second);
+	return &iter->second->second;
+}
+
+//==============================================================================
+// GeometryCache : ajout d'une geometrie, en retirant les plus anciennes si besoin
+// Renvoie nullptr si la geometrie est plus grosse que le budget
+//==============================================================================
+const FlatGeometry* GeometryCache::Insert(GIntBig id, const FlatGeometry& geom)
+{
+	if (id == OGRNullFID)
+		return nullptr;
+	auto iter = m_Map.find(id);
+	if (iter != m_Map.end()) {
+		m_nSize -= iter->second->second.Size();
+		m_List.erase(iter->second);
+		m_Map.erase(iter);
+	}
+	m_List.emplace_front(id, geom);	// La copie ajuste la capacite des tableaux
+	size_t size = m_List.front().second.Size();
+	if (size > m_nBudget) {
+		m_List.pop_front();
+		return nullptr;
+	}
+	Evict(size);
+	m_Map[id] = m_List.begin();
+	m_nSize += size;
+	return &m_List.front().second;
+}
+
+//==============================================================================
+// GeometryCache : liberation des geometries les plus anciennes
+//==============================================================================
+void GeometryCache::Evict(size_t needed)
+{
+	while ((m_nSize + needed > m_nBudget) && (m_Map.size() > 0)) {
+		auto last = std::prev(m_List.end());
+		if (m_Map.count(last->first) == 0)	// Geometrie en cours d'insertion
+			break;
+		m_nSize -= last->second.Size();
+		m_Map.erase(last->first);
+		m_List.pop_back();
+	}
+}
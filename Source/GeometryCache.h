@@ -0,0 +1,67 @@
+//==============================================================================
+// GeometryCache.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "ogrsf_frmts.h"
+
+//==============================================================================
+// FlatGeometry : geometrie deja projetee dans le systeme de la vue, stockee
+// sous forme de tableaux contigus (sommets, debut des parties, type des parties)
+//==============================================================================
+class FlatGeometry {
+public:
+	typedef enum { Point = 0, Line = 1, Ring = 2 } PartType;
+
+	OGREnvelope								Env;
+	int												Dimension;
+	bool											Fill;				// Polygones : la geometrie doit etre remplie
+	std::vector<double>				Pt;					// Sommets entrelaces (x0, y0, x1, y1 ...)
+	std::vector<int>					Parts;			// Indice du premier sommet de chaque partie, plus le nombre total de sommets
+	std::vector<unsigned char>	Types;			// Type de chaque partie
+
+	FlatGeometry() { Clear(); }
+	void Clear();
+	bool Set(const OGRGeometry* poGeom);
+	int NumParts() const { return (int)Types.size(); }
+	int PartStart(int i) const { return Parts[i]; }
+	int PartCount(int i) const { return Parts[i + 1] - Parts[i]; }
+	size_t Size() const;	// Memoire occupee (octets)
+
+protected:
+	void AddPart(const OGRGeometry* poGeom);
+	void AddCurve(const OGRSimpleCurve* poCurve, PartType type);
+};
+
+//==============================================================================
+// GeometryCache : cache LRU de geometries projetees, borne en memoire
+//==============================================================================
+class GeometryCache {
+public:
+	GeometryCache(size_t budget = 64 * 1024 * 1024) { m_nBudget = budget; m_nSize = 0; }
+
+	void SetBudget(size_t budget) { m_nBudget = budget; Evict(0); }
+	size_t Budget() const { return m_nBudget; }
+	size_t Size() const { return m_nSize; }
+	size_t Count() const { return m_Map.size(); }
+
+	const FlatGeometry* Find(GIntBig id);
+	const FlatGeometry* Insert(GIntBig id, const FlatGeometry& geom);
+	void Clear() { m_List.clear(); m_Map.clear(); m_nSize = 0; }
+
+private:
+	typedef std::list<std::pair<GIntBig, FlatGeometry> > List;
+	List																		m_List;	// Du plus recent au plus ancien
+	std::unordered_map<GIntBig, List::iterator>	m_Map;
+	size_t																	m_nSize;
+	size_t																	m_nBudget;
+
+	void Evict(size_t needed);
+};
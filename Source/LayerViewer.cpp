@@ -71,6 +71,12 @@ void LayerViewerModel::paintCell(juce::Graphics& g, int rowNumber, int columnId,
 		g.setColour(juce::Colour(geoLayer->m_Repres.FillColor));
 		g.fillRect(0, 0, width, height);
 		break;
+	case Column::Decimation:// Simplification
+		g.drawText(juce::String(geoLayer->m_Repres.Decimation, 2), 0, 0, width, height, juce::Justification::centred);
+		break;
+	case Column::SymbolSize:// Symbole des points
+		g.drawText(juce::String(geoLayer->m_Repres.SymbolSize), 0, 0, width, height, juce::Justification::centred);
+		break;
 	}
 }
 
@@ -130,6 +136,32 @@ void LayerViewerModel::cellClicked(int rowNumber, int columnId, const juce::Mous
 		juce::CallOutBox::launchAsynchronously(std::move(widthSelector), bounds, nullptr);
 		return;
 	}
+	// Choix d'une tolerance de simplification
+	if (columnId == Column::Decimation) {
+		auto toleranceSelector = std::make_unique<juce::Slider>();
+		toleranceSelector->setRange(0., 5., 0.25);
+		toleranceSelector->setValue(geoLayer->m_Repres.Decimation);
+		toleranceSelector->setSliderStyle(juce::Slider::LinearHorizontal);
+		toleranceSelector->setTextBoxStyle(juce::Slider::TextBoxLeft, false, 80, 20);
+		toleranceSelector->setSize(200, 50);
+		toleranceSelector->setChangeNotificationOnlyOnRelease(true);
+		toleranceSelector->addListener(this);
+		juce::CallOutBox::launchAsynchronously(std::move(toleranceSelector), bounds, nullptr);
+		return;
+	}
+	// Choix de la taille du symbole des points
+	if (columnId == Column::SymbolSize) {
+		auto sizeSelector = std::make_unique<juce::Slider>();
+		sizeSelector->setRange(0., 20., 1.);
+		sizeSelector->setValue(geoLayer->m_Repres.SymbolSize);
+		sizeSelector->setSliderStyle(juce::Slider::LinearHorizontal);
+		sizeSelector->setTextBoxStyle(juce::Slider::TextBoxLeft, false, 80, 20);
+		sizeSelector->setSize(200, 50);
+		sizeSelector->setChangeNotificationOnlyOnRelease(true);
+		sizeSelector->addListener(this);
+		juce::CallOutBox::launchAsynchronously(std::move(sizeSelector), bounds, nullptr);
+		return;
+	}
 }
 
 //==============================================================================
@@ -186,7 +218,7 @@ void LayerViewerModel::changeListenerCallback(juce::ChangeBroadcaster* source)
 				geoLayer->m_Repres.PenColor = color;
 			if (m_ActiveColumn == Column::FillColour)
 				geoLayer->m_Repres.FillColor = color;
-			sendActionMessage("UpdateVector");
+			sendActionMessage("UpdateVectorStyle:" + juce::String(geoLayer->Id()));
 		}
 	}
 }
@@ -206,7 +238,21 @@ void LayerViewerModel::sliderValueChanged(juce::Slider* slider)
 	if (m_ActiveColumn == Column::PenWidth) {
 		if (geoLayer->m_Repres.PenSize != (int)slider->getValue()) {
 			geoLayer->m_Repres.PenSize = (int)slider->getValue();
-			sendActionMessage("UpdateVector");
+			sendActionMessage("UpdateVectorStyle:" + juce::String(geoLayer->Id()));
+		}
+	}
+	// Choix d'une tolerance de simplification
+	if (m_ActiveColumn == Column::Decimation) {
+		if (geoLayer->m_Repres.Decimation != (float)slider->getValue()) {
+			geoLayer->m_Repres.Decimation = (float)slider->getValue();
+			sendActionMessage("UpdateVectorStyle:" + juce::String(geoLayer->Id()));
+		}
+	}
+	// Choix de la taille du symbole des points
+	if (m_ActiveColumn == Column::SymbolSize) {
+		if (geoLayer->m_Repres.SymbolSize != (float)slider->getValue()) {
+			geoLayer->m_Repres.SymbolSize = (float)slider->getValue();
+			sendActionMessage("UpdateVectorStyle:" + juce::String(geoLayer->Id()));
 		}
 	}
 }
@@ -228,7 +274,9 @@ LayerViewer::LayerViewer()
 	m_Table.getHeader().addColumn(juce::translate("Width"), LayerViewerModel::Column::PenWidth, 50);
 	m_Table.getHeader().addColumn(juce::translate("Pen"), LayerViewerModel::Column::PenColour, 50);
 	m_Table.getHeader().addColumn(juce::translate("Brush"), LayerViewerModel::Column::FillColour, 50);
-	m_Table.setSize(352, 200);
+	m_Table.getHeader().addColumn(juce::translate("Simplification"), LayerViewerModel::Column::Decimation, 50);
+	m_Table.getHeader().addColumn(juce::translate("Symbol"), LayerViewerModel::Column::SymbolSize, 50);
+	m_Table.setSize(452, 200);
 	m_Table.setModel(&m_Model);
 	addAndMakeVisible(m_Table);
 }
@@ -243,6 +291,8 @@ void LayerViewer::UpdateColumnName()
 	m_Table.getHeader().setColumnName(LayerViewerModel::Column::PenWidth, juce::translate("Width"));
 	m_Table.getHeader().setColumnName(LayerViewerModel::Column::PenColour, juce::translate("Pen"));
 	m_Table.getHeader().setColumnName(LayerViewerModel::Column::FillColour, juce::translate("Brush"));
+	m_Table.getHeader().setColumnName(LayerViewerModel::Column::Decimation, juce::translate("Simplification"));
+	m_Table.getHeader().setColumnName(LayerViewerModel::Column::SymbolSize, juce::translate("Symbol"));
 }
 
 //==============================================================================
@@ -250,7 +300,7 @@ void LayerViewer::UpdateColumnName()
 //==============================================================================
 void LayerViewer::actionListenerCallback(const juce::String& message)
 {
-	if (message == "UpdateVector") {
+	if ((message == "UpdateVector") || (message.startsWith("UpdateVectorStyle:"))) {
 		repaint();
 	}
 }
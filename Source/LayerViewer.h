@@ -18,7 +18,7 @@ class LayerViewerModel :	public juce::TableListBoxModel,
 													public juce::Slider::Listener,
 													public juce::ActionBroadcaster {
 public:
-	typedef enum { Visibility = 1, Name = 2, PenWidth = 3, PenColour = 4, FillColour = 5 } Column;
+	typedef enum { Visibility = 1, Name = 2, PenWidth = 3, PenColour = 4, FillColour = 5, Decimation = 6, SymbolSize = 7 } Column;
 	LayerViewerModel();
 
 	int getNumRows() override;
@@ -11,6 +11,7 @@
 MainComponent::MainComponent()
 {
 	GDALAllRegister();	// Registration des drivers
+	m_Base.SetIndexFolder(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("GdalMapIndex").getFullPathName().toStdString());
 
 	m_MapView.reset(new MapView);
 	addAndMakeVisible(m_MapView.get());
@@ -42,6 +43,15 @@ MainComponent::MainComponent()
 	m_SelTreeViewer.get()->SetBase(&m_Base);
 	m_SelTreeViewer.get()->addActionListener(this);
 	
+	m_Loader.reset(new DatasetLoader(&m_Base));
+	m_Loader.get()->addActionListener(this);
+	m_LoadingViewer.reset(new LoadingViewer(*m_Loader.get()));
+	addChildComponent(m_LoadingViewer.get());
+
+	m_OverviewBuilder.reset(new OverviewBuilder);
+	m_OverviewBuilder.get()->addActionListener(this);
+	m_RasterLayerViewer.get()->SetBuilder(m_OverviewBuilder.get());
+
 	m_FeatureViewer.reset(new FeatureViewer("Feature", juce::Colours::grey, juce::DocumentWindow::allButtons));
 	m_FeatureViewer.get()->setVisible(false);
 
@@ -84,7 +94,9 @@ MainComponent::MainComponent()
 
 MainComponent::~MainComponent()
 {
-	
+	m_Loader.get()->Cancel();
+	m_Loader.get()->stopThread(-1);
+	m_OverviewBuilder.get()->Cancel();
 }
 
 void MainComponent::resized()
@@ -98,6 +110,8 @@ void MainComponent::resized()
 	R.setTop(juce::LookAndFeel::getDefaultLookAndFeel().getDefaultMenuBarHeight());
 	R.setBottom(b.getBottom());
 	//m_MapView->setBounds(R);
+	if (m_LoadingViewer.get()->isVisible())
+		m_LoadingViewer.get()->setBounds(R.removeFromBottom(28));
 
 	Component* vcomps[] = { m_MapView.get(), m_VerticalDividerBar.get(), m_Panel.get()};
 
@@ -132,11 +146,13 @@ juce::PopupMenu MainComponent::getMenuForIndex(int menuIndex, const juce::String
 	{
 		menu.addCommandItem(&m_CommandManager, CommandIDs::menuTranslate);
 		menu.addCommandItem(&m_CommandManager, CommandIDs::menuTest);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuBenchmark);
 	}
 	else if (menuIndex == 2) // Layers
 	{
 		menu.addCommandItem(&m_CommandManager, CommandIDs::menuAddVectorLayer);
 		menu.addCommandItem(&m_CommandManager, CommandIDs::menuAddRasterLayer);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuAddRasterFolder);
 		menu.addCommandItem(&m_CommandManager, CommandIDs::menuAddDtmLayer);
 		juce::PopupMenu WmtsSubMenu;
 		WmtsSubMenu.addCommandItem(&m_CommandManager, CommandIDs::menuAddOSM);
@@ -163,6 +179,12 @@ juce::PopupMenu MainComponent::getMenuForIndex(int menuIndex, const juce::String
 		ScaleSubMenu.addCommandItem(&m_CommandManager, CommandIDs::menuScale100k);
 		ScaleSubMenu.addCommandItem(&m_CommandManager, CommandIDs::menuScale250k);
 		menu.addSubMenu(juce::translate("Scale"), ScaleSubMenu);
+		menu.addSeparator();
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuParallelRendering);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuBatchRendering);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuProgressiveRendering);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuTileCache);
+		menu.addCommandItem(&m_CommandManager, CommandIDs::menuTileDiskCache);
 	}
 	else if (menuIndex == 4) // Help
 	{
@@ -189,10 +211,11 @@ void MainComponent::getAllCommands(juce::Array<juce::CommandID>& c)
 {
 	juce::Array<juce::CommandID> commands{ CommandIDs::menuNew, CommandIDs::menuOpenImage, CommandIDs::menuOpenVector, CommandIDs::menuOpenFolder,
 		CommandIDs::menuQuit, CommandIDs::menuUndo, CommandIDs::menuTranslate,
-		CommandIDs::menuAddVectorLayer, CommandIDs::menuAddRasterLayer, CommandIDs::menuAddDtmLayer, 
+		CommandIDs::menuAddVectorLayer, CommandIDs::menuAddRasterLayer, CommandIDs::menuAddRasterFolder, CommandIDs::menuAddDtmLayer, 
 		CommandIDs::menuZoomTotal, CommandIDs::menuZoomLevel,
-		CommandIDs::menuTest, CommandIDs::menuShowSidePanel,
-		CommandIDs::menuShowFeatureViewer, CommandIDs::menuAddOSM, CommandIDs::menuAddGeoportailOrthophoto, 
+		CommandIDs::menuTest, CommandIDs::menuBenchmark, CommandIDs::menuShowSidePanel,
+		CommandIDs::menuShowFeatureViewer, CommandIDs::menuParallelRendering, CommandIDs::menuBatchRendering,
+		CommandIDs::menuProgressiveRendering, CommandIDs::menuTileCache, CommandIDs::menuTileDiskCache, CommandIDs::menuAddOSM, CommandIDs::menuAddGeoportailOrthophoto, 
 		CommandIDs::menuAddGeoportailOrthohisto, CommandIDs::menuAddGeoportailSatellite, CommandIDs::menuAddGeoportailCartes,
 		CommandIDs::menuAddWmtsServer, 
 		CommandIDs::menuScale1k, CommandIDs::menuScale10k, CommandIDs::menuScale25k, CommandIDs::menuScale100k, CommandIDs::menuScale250k,
@@ -230,12 +253,18 @@ void MainComponent::getCommandInfo(juce::CommandID commandID, juce::ApplicationC
 	case CommandIDs::menuTranslate:
 		result.setInfo(juce::translate("Translate"), juce::translate("Load a translation file"), "Menu", 0);
 		break;
+	case CommandIDs::menuBenchmark:
+		result.setInfo(juce::translate("Rendering benchmark"), juce::translate("Rendering benchmark"), "Menu", 0);
+		break;
 	break; case CommandIDs::menuAddVectorLayer:
 		result.setInfo(juce::translate("Add vector data"), juce::translate("Add vector data"), "Menu", 0);
 		break;
 	case CommandIDs::menuAddRasterLayer:
 		result.setInfo(juce::translate("Add raster data"), juce::translate("Add raster data"), "Menu", 0);
 		break;
+	case CommandIDs::menuAddRasterFolder:
+		result.setInfo(juce::translate("Add a folder of images"), juce::translate("Add a folder of images"), "Menu", 0);
+		break;
 	case CommandIDs::menuAddDtmLayer:
 		result.setInfo(juce::translate("Add a DTM layer"), juce::translate("Add a DTM layer"), "Menu", 0);
 		break;
@@ -288,6 +317,31 @@ void MainComponent::getCommandInfo(juce::CommandID commandID, juce::ApplicationC
 		if (m_FeatureViewer.get() != nullptr)
 			result.setTicked(m_FeatureViewer.get()->isVisible());
 		break;
+	case CommandIDs::menuParallelRendering:
+		result.setInfo(juce::translate("Parallel rendering"), juce::translate("Parallel rendering"), "Menu", 0);
+		if (m_MapView.get() != nullptr)
+			result.setTicked(m_MapView.get()->Parallel());
+		break;
+	case CommandIDs::menuBatchRendering:
+		result.setInfo(juce::translate("Batched rendering"), juce::translate("Batched rendering"), "Menu", 0);
+		if (m_MapView.get() != nullptr)
+			result.setTicked(m_MapView.get()->Batch());
+		break;
+	case CommandIDs::menuProgressiveRendering:
+		result.setInfo(juce::translate("Progressive rendering"), juce::translate("Progressive rendering"), "Menu", 0);
+		if (m_MapView.get() != nullptr)
+			result.setTicked(m_MapView.get()->Progressive());
+		break;
+	case CommandIDs::menuTileCache:
+		result.setInfo(juce::translate("Tile cache"), juce::translate("Tile cache"), "Menu", 0);
+		if (m_MapView.get() != nullptr)
+			result.setTicked(m_MapView.get()->Tiles());
+		break;
+	case CommandIDs::menuTileDiskCache:
+		result.setInfo(juce::translate("Tile cache on disk"), juce::translate("Tile cache on disk"), "Menu", 0);
+		if (m_MapView.get() != nullptr)
+			result.setTicked(m_MapView.get()->TileDiskCache());
+		break;
 	case CommandIDs::gdalAbout:
 		result.setInfo(juce::translate("About GdalMap"), juce::translate("About GdalMap"), "Menu", 0);
 		break;
@@ -325,12 +379,19 @@ bool MainComponent::perform(const InvocationInfo& info)
 	case CommandIDs::menuTest:
 		Test();
 		break;
+	case CommandIDs::menuBenchmark:
+		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, juce::translate("Rendering benchmark"),
+			VectorRenderer::Benchmark(), "OK");
+		break;
 	case CommandIDs::menuAddVectorLayer:
 		AddVectorLayer();
 		break;
 	case CommandIDs::menuAddRasterLayer:
 		AddRasterLayer();
 		break;
+	case CommandIDs::menuAddRasterFolder:
+		AddRasterFolder();
+		break;
 	case CommandIDs::menuAddDtmLayer:
 		AddDtmLayer();
 		break;
@@ -393,6 +454,31 @@ bool MainComponent::perform(const InvocationInfo& info)
 			return false;
 		m_FeatureViewer.get()->setVisible(!m_FeatureViewer.get()->isVisible());
 		break;
+	case CommandIDs::menuParallelRendering:
+		if (m_MapView.get() == nullptr)
+			return false;
+		m_MapView.get()->SetParallel(!m_MapView.get()->Parallel());
+		break;
+	case CommandIDs::menuBatchRendering:
+		if (m_MapView.get() == nullptr)
+			return false;
+		m_MapView.get()->SetBatch(!m_MapView.get()->Batch());
+		break;
+	case CommandIDs::menuProgressiveRendering:
+		if (m_MapView.get() == nullptr)
+			return false;
+		m_MapView.get()->SetProgressive(!m_MapView.get()->Progressive());
+		break;
+	case CommandIDs::menuTileCache:
+		if (m_MapView.get() == nullptr)
+			return false;
+		m_MapView.get()->SetTiles(!m_MapView.get()->Tiles());
+		break;
+	case CommandIDs::menuTileDiskCache:
+		if (m_MapView.get() == nullptr)
+			return false;
+		m_MapView.get()->SetTileDiskCache(!m_MapView.get()->TileDiskCache());
+		break;
 	case CommandIDs::gdalAbout:
 		AboutGdalMap();
 		break;
@@ -410,7 +496,24 @@ void MainComponent::actionListenerCallback(const juce::String& message)
 {
 	if (m_MapView == nullptr)
 		return;
+	if (message == "DatasetLoaded") {
+		LoadingDone();
+		return;
+	}
+	if (message == "OverviewsBuilt") {
+		m_MapView.get()->StopRendering();
+		if (m_OverviewBuilder.get()->Commit(&m_Base))
+			m_MapView.get()->RenderMap(false, true, false, false);
+		m_RasterLayerViewer.get()->repaint();
+		return;
+	}
 	if (message == "UpdateVector") {
+		StartIndexing();	// Layers affiches pour la premiere fois
+		m_MapView.get()->RenderMap(true, false, false, true, true);
+		return;
+	}
+	if (message.startsWith("UpdateVectorStyle:")) {
+		m_MapView.get()->InvalidateLayer(message.fromFirstOccurrenceOf(":", false, false).getIntValue());
 		m_MapView.get()->RenderMap(true, false, false, true, true);
 		return;
 	}
@@ -544,7 +647,11 @@ void MainComponent::SaveAppOption(juce::String name, juce::String value)
 //==============================================================================
 void MainComponent::Clear()
 {
+	m_Loader.get()->Cancel();	// Les layers en cours d'indexation vont etre detruits
+	m_Loader.get()->waitForThreadToExit(-1);
 	m_MapView.get()->StopThread();
+	m_OverviewBuilder.get()->Cancel();
+	m_OverviewBuilder.get()->Commit(&m_Base);
 	m_Base.Clear();
 	m_FeatureViewer.get()->SetBase(&m_Base);
 	m_LayerViewer.get()->SetBase(&m_Base);
@@ -566,6 +673,90 @@ void MainComponent::AboutGdalMap()
 		juce::translate("About GdalMap"), message, "OK");
 }
 
+//==============================================================================
+// Chargement d'un dataset dans le thread de chargement
+//==============================================================================
+bool MainComponent::StartLoading(juce::String filename, DatasetLoader::DatasetType type, juce::String name)
+{
+	if (!m_Loader.get()->Load(filename, type, name)) {
+		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "GdalMap",
+			juce::translate("A dataset is already being loaded"), "OK");
+		return false;
+	}
+	m_LoadingViewer.get()->setVisible(true);
+	resized();
+	return true;
+}
+
+//==============================================================================
+// Fin du chargement : ajout du dataset a la base
+//==============================================================================
+void MainComponent::LoadingDone()
+{
+	m_LoadingViewer.get()->setVisible(false);
+	resized();
+	DatasetLoader* loader = m_Loader.get();
+	if (loader->Type() == DatasetLoader::Index) {
+		IndexingDone();
+		return;
+	}
+	if (loader->Cancelled()) {
+		loader->Commit();
+		return;
+	}
+	if (!loader->Succeeded()) {
+		loader->Commit();
+		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "GdalMap",
+			loader->Filename() + juce::translate(" : this file cannot be opened"), "OK");
+		return;
+	}
+	m_MapView.get()->StopRendering();
+	loader->Commit();
+	if (m_Base.GetEnvelope().IsInit())	// Sinon, l'emprise est connue a la fin de l'indexation
+		m_MapView.get()->SetFrame(m_Base.GetEnvelope());
+	if (loader->Type() == DatasetLoader::Vector) {
+		m_MapView.get()->RenderMap(true, false, false, true, true);
+		m_LayerViewer.get()->SetBase(&m_Base);
+		StartIndexing();
+	}
+	if ((loader->Type() == DatasetLoader::Raster) || (loader->Type() == DatasetLoader::RasterFolder))
+		m_RasterLayerViewer.get()->SetBase(&m_Base);
+}
+
+//==============================================================================
+// Indexation des layers vecteurs visibles dans le thread de chargement : les layers
+// sont dessines et selectionnables une fois indexes
+//==============================================================================
+void MainComponent::StartIndexing()
+{
+	if (m_Loader.get()->IsLoading())	// Relance a la fin du chargement en cours
+		return;
+	if (!m_Loader.get()->IndexLayers(m_Base.UnindexedLayers()))
+		return;
+	m_LoadingViewer.get()->setVisible(true);
+	resized();
+}
+
+//==============================================================================
+// Fin de l'indexation : les layers non indexes (interruption, erreur) sont caches
+//==============================================================================
+void MainComponent::IndexingDone()
+{
+	DatasetLoader* loader = m_Loader.get();
+	bool indexed = loader->Commit();
+	if (!indexed) {
+		m_Base.HideUnindexedLayers();
+		m_LayerViewer.get()->SetBase(&m_Base);
+	}
+	bool frame = m_Base.GetEnvelope().IsInit();
+	m_Base.UpdateEnvelope();
+	if ((!frame) && (m_Base.GetEnvelope().IsInit()))
+		m_MapView.get()->SetFrame(m_Base.GetEnvelope());
+	m_MapView.get()->RenderMap(true, false, false, true, true);
+	if (indexed)	// Layers affiches pendant l'indexation
+		StartIndexing();
+}
+
 //==============================================================================
 // Ajout d'une couche vectorielle
 //==============================================================================
@@ -579,16 +770,7 @@ bool MainComponent::AddVectorLayer()
 			filename + juce::translate(" is already opened"), "OK");
 		return false;
 	}
-	if (!m_Base.OpenVectorDataset(filename.getCharPointer())) {
-		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "GdalMap", 
-			filename + juce::translate(" : this file cannot be opened"), "OK");
-			return false;
-	}
-	m_MapView.get()->SetFrame(m_Base.GetEnvelope());
-	m_MapView.get()->RenderMap(true, false, false, true, true);
-	m_LayerViewer.get()->SetBase(&m_Base);
-
-	return true;
+	return StartLoading(filename, DatasetLoader::Vector);
 }
 
 //==============================================================================
@@ -609,15 +791,18 @@ bool MainComponent::AddRasterLayer(juce::String rasterfile)
 			filename + juce::translate(" is already opened"), "OK");
 		return false;
 	}
-	if (!m_Base.OpenRasterDataset(filename.getCharPointer(), name.getCharPointer()) ){
-		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "GdalMap",
-			filename + juce::translate(" : this file cannot be opened"), "OK");
-		return false;
-	}
-	m_MapView.get()->SetFrame(m_Base.GetEnvelope());
-	m_RasterLayerViewer.get()->SetBase(&m_Base);
+	return StartLoading(filename, DatasetLoader::Raster, name);
+}
 
-	return true;
+//==============================================================================
+// Ajout d'un repertoire d'images formant une seule couche raster
+//==============================================================================
+bool MainComponent::AddRasterFolder()
+{
+	juce::String folder = OpenFolder("RasterFolderPath");
+	if (folder.isEmpty())
+		return false;
+	return StartLoading(folder, DatasetLoader::RasterFolder, juce::File(folder).getFileName());
 }
 
 //==============================================================================
@@ -652,15 +837,7 @@ bool MainComponent::AddDtmLayer(juce::String dtmfile)
 			filename + juce::translate(" is already opened"), "OK");
 		return false;
 	}
-	if (!m_Base.OpenRasterDataset(filename.getCharPointer(), name.getCharPointer(), true, nullptr, true)) {
-		juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "GdalMap",
-			filename + juce::translate(" : this file cannot be opened"), "OK");
-		return false;
-	}
-	m_MapView.get()->SetFrame(m_Base.GetEnvelope());
-	//m_RasterLayerViewer.get()->SetBase(&m_Base);
-
-	return true;
+	return StartLoading(filename, DatasetLoader::Dtm, name);
 }
 
 //==============================================================================
@@ -730,6 +907,7 @@ void MainComponent::Test()
 	m_MapView.get()->SetFrame(m_Base.GetEnvelope());
 	m_MapView.get()->RenderMap(true, false, false, true, true);
 	m_LayerViewer.get()->SetBase(&m_Base);
+	StartIndexing();
 
 	return ;
 }
@@ -17,6 +17,8 @@
 #include "RasterLayerViewer.h"
 #include "DtmViewer.h"
 #include "SelTreeViewer.h"
+#include "DatasetLoader.h"
+#include "OverviewBuilder.h"
 
 //==============================================================================
 /*
@@ -34,11 +36,12 @@ public:
   {
     menuNew = 1, menuOpenImage, menuOpenVector, menuOpenFolder, menuQuit,
     menuUndo,
-    menuTranslate, menuTest,
-    menuAddVectorLayer, menuAddRasterLayer, menuAddDtmLayer,
+    menuTranslate, menuTest, menuBenchmark,
+    menuAddVectorLayer, menuAddRasterLayer, menuAddRasterFolder, menuAddDtmLayer,
     menuZoomTotal, menuZoomLevel,
     menuScale1k, menuScale10k, menuScale25k, menuScale100k, menuScale250k,
-    menuShowSidePanel, menuShowFeatureViewer,
+    menuShowSidePanel, menuShowFeatureViewer, menuParallelRendering, menuBatchRendering,
+    menuProgressiveRendering, menuTileCache, menuTileDiskCache,
     menuAddOSM, menuAddWmtsServer,
     menuAddGeoportailOrthophoto, menuAddGeoportailOrthohisto, menuAddGeoportailSatellite, menuAddGeoportailCartes,
     gdalAbout
@@ -80,6 +83,9 @@ private:
   std::unique_ptr <juce::ConcertinaPanel> m_Panel;
  
   GeoBase   m_Base;
+  std::unique_ptr<DatasetLoader> m_Loader;
+  std::unique_ptr<LoadingViewer> m_LoadingViewer;
+  std::unique_ptr<OverviewBuilder> m_OverviewBuilder;
  
   juce::String OpenFolder(juce::String optionName = "", juce::String mes = "");
   juce::String OpenFile(juce::String optionName = "", juce::String mes = "", juce::String filter = "");
@@ -93,8 +99,13 @@ private:
 
   void OpenVector();
 
+  bool StartLoading(juce::String filename, DatasetLoader::DatasetType type, juce::String name = "");
+  void LoadingDone();
+  void StartIndexing();
+  void IndexingDone();
   bool AddVectorLayer();
   bool AddRasterLayer(juce::String rasterfile = "");
+  bool AddRasterFolder();
   bool AddMultiRasterLayer(juce::String server = "");
   bool AddDtmLayer(juce::String dtmfile = "");
   bool AddOSMServer();
@@ -5,41 +5,204 @@
 // Date : 16/12/2021
 //==============================================================================
 
+#include <algorithm>
+#include <cmath>
 #include "MapThread.h"
 #include "GeoBase.h"
 #include "DtmShader.h"
+#include "RasterCache.h"
+
+//==============================================================================
+// VectorLayerJob : dessin d'un layer vectoriel dans sa propre image
+//==============================================================================
+class VectorLayerJob : public juce::ThreadPoolJob {
+public:
+	VectorLayerJob(GeoBase::VectorLayer* layer, int W, int H, const double& X0, const double& Y0, const double& scale,
+		const juce::Rectangle<int>& clip, bool batch) : juce::ThreadPoolJob("VectorLayerJob")
+	{
+		m_Layer = layer; m_nW = W; m_nH = H; m_Clip = clip;
+		m_Renderer.SetWorld(X0, Y0, scale);
+		m_Renderer.SetClip(clip);
+		m_Renderer.SetBatch(batch);
+	}
+
+	juce::Image& Image() { return m_Image; }
+	juce::int64 NumObjects() { return m_Renderer.NumObjects(); }
+
+	JobStatus runJob() override
+	{
+		m_Image = juce::Image(juce::Image::PixelFormat::ARGB, m_nW, m_nH, true);
+		OGRSpatialReference spatialRef;
+		spatialRef.importFromEPSG(3857);
+		// Lecture dans un dataset du pool : seul l'etat de dessin du layer est verrouille. Sinon, le dataset
+		// partage avec d'autres layers est verrouille
+		GeoBase::VectorLayer::Reader reader(m_Layer, GeoBase::VectorLayer::Reader::None);
+		OGRLayer* source = reader.Layer();
+		std::mutex& mutex = (source != nullptr) ? m_Layer->DrawMutex() : m_Layer->Mutex();
+		GeoBase::Transformation* transfo = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (source != nullptr) {
+				transfo = GeoBase::Transformation::Get(source->GetSpatialRef(), &spatialRef);
+				const OGREnvelope& rect = m_Layer->FilterRect();
+				if (m_Layer->FastSpatialFilter())
+					source->SetSpatialFilterRect(rect.MinX, rect.MinY, rect.MaxX, rect.MaxY);
+				source->ResetReading();
+				m_Layer->ResetIndex();
+			}
+			else {
+				transfo = GeoBase::Transformation::Get(m_Layer->SpatialRef(), &spatialRef);
+				m_Layer->ResetReading();
+			}
+		}
+		if (transfo == nullptr)
+			return jobHasFinished;
+		juce::Graphics g(m_Image);
+		g.excludeClipRegion(m_Clip);
+		bool more = true;
+		while ((more) && (!shouldExit())) {
+			std::lock_guard<std::mutex> lock(mutex);
+			more = m_Renderer.DrawFeatures(m_Layer, g, transfo, 100, source);
+		}
+		m_Renderer.Flush(g);
+		if (source != nullptr)
+			source->ResetReading();
+		return jobHasFinished;
+	}
+
+private:
+	GeoBase::VectorLayer* m_Layer;
+	int										m_nW, m_nH;
+	juce::Rectangle<int>	m_Clip;
+	VectorRenderer				m_Renderer;
+	juce::Image						m_Image;
+};
+
+//==============================================================================
+// ProgressiveLayer : etat d'un layer vectoriel pendant le dessin progressif
+//==============================================================================
+struct ProgressiveLayer {
+	GeoBase::VectorLayer*				Layer;
+	GeoBase::Transformation*		Transfo;
+	juce::Image									Image;		// Image propre au layer
+	double											Cx, Cy;		// Centre de la vue (systeme du layer)
+	double											MinSize;	// Taille minimum des gros objets (systeme du layer)
+	std::vector<std::pair<double, GeoBase::Feature> > Fine;	// Petits objets lus, avec leur distance au centre
+	std::vector<GeoBase::Feature> Pass;		// Petits objets du centre vers les bords, dessines apres la lecture
+	size_t											Index;
+	bool												Stream;		// Pas d'index : lecture dans l'ordre du dataset
+	bool												More[2];	// Lecture (et dessin des gros objets) puis passe fine en cours
+};
+
+//==============================================================================
+// Distance (au carre) d'une enveloppe au centre de la vue, comme l'index
+//==============================================================================
+static double CenterDistance(const ProgressiveLayer& p, const OGREnvelope& env)
+{
+	double dx = juce::jmax(0., juce::jmax(env.MinX - p.Cx, p.Cx - env.MaxX));
+	double dy = juce::jmax(0., juce::jmax(env.MinY - p.Cy, p.Cy - env.MaxY));
+	return dx * dx + dy * dy;
+}
+
+//==============================================================================
+// Lecture d'au plus maxFeatures features d'un layer pour le dessin progressif :
+// les gros objets sont dessines aussitot, du plus proche au plus eloigne du centre,
+// les petits sont gardes pour la passe fine. Avec l'index, les features arrivent
+// deja par distance croissante ; sans index, chaque lot est trie, les petits objets
+// sont projetes dans le cache et tries a la fin de la lecture
+// Renvoie false quand la lecture est terminee
+//==============================================================================
+static bool ScanProgressive(ProgressiveLayer& p, VectorRenderer& renderer, juce::Graphics& g, int maxFeatures)
+{
+	auto nearer = [](const std::pair<double, GeoBase::Feature>& a, const std::pair<double, GeoBase::Feature>& b) { return a.first < b.first; };
+	bool more = true;
+	OGREnvelope env;
+	if (p.Stream) {
+		std::vector<std::pair<double, OGRFeature*> > coarse;
+		for (int i = 0; i < maxFeatures; i++) {
+			OGRFeature* poFeature = p.Layer->GetNextFeature();
+			if (poFeature == nullptr) {
+				more = false;
+				break;
+			}
+			const OGRGeometry* poGeom = poFeature->GetGeometryRef();
+			if (poGeom == nullptr) {
+				OGRFeature::DestroyFeature(poFeature);
+				continue;
+			}
+			poGeom->getEnvelope(&env);
+			double d = CenterDistance(p, env);
+			if (juce::jmax(env.MaxX - env.MinX, env.MaxY - env.MinY) >= p.MinSize) {
+				coarse.push_back(std::make_pair(d, poFeature));
+				continue;
+			}
+			p.Fine.push_back(std::make_pair(d, GeoBase::Feature(poFeature->GetFID(), env, p.Layer->Id())));
+			renderer.CacheFeature(p.Layer, p.Transfo, poFeature);
+			OGRFeature::DestroyFeature(poFeature);
+		}
+		std::stable_sort(coarse.begin(), coarse.end(),
+			[](const std::pair<double, OGRFeature*>& a, const std::pair<double, OGRFeature*>& b) { return a.first < b.first; });
+		for (size_t i = 0; i < coarse.size(); i++) {
+			renderer.DrawFeature(p.Layer, g, p.Transfo, coarse[i].second);
+			OGRFeature::DestroyFeature(coarse[i].second);
+		}
+		if (!more)
+			std::stable_sort(p.Fine.begin(), p.Fine.end(), nearer);
+	}
+	else {
+		GIntBig id;
+		for (int i = 0; i < maxFeatures; i++) {
+			if (!p.Layer->GetNextFeatureId(id, env)) {
+				more = false;
+				break;
+			}
+			if (juce::jmax(env.MaxX - env.MinX, env.MaxY - env.MinY) >= p.MinSize)
+				renderer.DrawFeatureId(p.Layer, g, p.Transfo, id);
+			else
+				p.Fine.push_back(std::make_pair(0., GeoBase::Feature(id, env, p.Layer->Id())));
+		}
+	}
+	if (more)
+		return true;
+	renderer.Flush(g);
+	p.Pass.reserve(p.Fine.size());
+	for (size_t i = 0; i < p.Fine.size(); i++)
+		p.Pass.push_back(p.Fine[i].second);
+	p.Fine.clear();
+	p.Fine.shrink_to_fit();
+	return false;
+}
+
+//==============================================================================
+// Composition des images des layers au-dessus de l'image de base
+//==============================================================================
+static void ComposeLayers(juce::Image& target, const juce::Image& base, std::vector<ProgressiveLayer>& layers)
+{
+	target.clear(target.getBounds());
+	juce::Graphics g(target);
+	g.drawImageAt(base, 0, 0);
+	for (size_t i = 0; i < layers.size(); i++)
+		g.drawImageAt(layers[i].Image, 0, 0);
+}
 
 MapThread::MapThread(const juce::String& threadName, size_t threadStackSize) : juce::Thread(threadName, threadStackSize) 
 { 
-	m_bFill = false;
-	m_nPtAlloc = 0;
-	m_Pt = nullptr;
 	m_Base = nullptr;
 	m_nNumObjects = 0;
 	m_dX0 = m_dY0 = 0.;
 	m_dScale = 1.0;
 	m_bRaster = m_bVector = m_bOverlay = m_bDtm = m_bRasterDone = false;
+	m_bRasterValid = m_bDtmValid = false;
+	m_bParallel = false;
+	m_bBatch = false;
+	m_bTiles = false;
+	m_bProgressive = false;
+	m_nLastPublish = 0;
 	m_SpatialRef.importFromEPSG(3857);
 }
 
 MapThread::~MapThread()
 {
-	if (m_Pt != nullptr)
-		delete[] m_Pt;
-}
-
-bool MapThread::AllocPoints(int numPt)
-{
-	m_Path.preallocateSpace(3 * numPt + 1);
-	if (numPt < m_nPtAlloc)
-		return true;
-	if (m_Pt != nullptr)
-		delete[] m_Pt;
-	m_Pt = new double[numPt * 2];
-	if (m_Pt == nullptr)
-		return false;
-	m_nPtAlloc = numPt;
-	return true;
 }
 
 void MapThread::SetDimension(const int& w, const int& h)
@@ -52,6 +215,9 @@ void MapThread::SetDimension(const int& w, const int& h)
 		m_Dtm = juce::Image(juce::Image::PixelFormat::ARGB, w, h, true);
 		m_RawDtm = juce::Image(juce::Image::PixelFormat::ARGB, w, h, true);
 		m_bRasterDone = false;
+		m_bRasterValid = m_bDtmValid = false;
+		m_RasterRegion = juce::RectangleList<int>(m_Raster.getBounds());
+		m_DtmRegion = juce::RectangleList<int>(m_Dtm.getBounds());
 	}
 }
 
@@ -63,15 +229,64 @@ void MapThread::SetUpdate(bool overlay, bool raster, bool dtm, bool vector)
 	m_bDtm = dtm;
 }
 
+//==============================================================================
+// Decalage du contenu d'une image de (dX, dY) pixels : les zones decouvertes sont
+// remplies avec background et renvoyees. Copie memoire exacte : les images MNT
+// brutes contiennent des flottants qui ne doivent pas passer par juce::Graphics
+//==============================================================================
+static juce::RectangleList<int> ShiftImage(juce::Image& image, int dX, int dY, juce::Colour background)
+{
+	juce::Rectangle<int> bounds = image.getBounds();
+	juce::Rectangle<int> kept = bounds.translated(dX, dY).getIntersection(bounds);
+	juce::RectangleList<int> region(bounds);
+	if (kept.isEmpty()) {
+		image.clear(bounds, background);
+		return region;
+	}
+	{
+		juce::Image::BitmapData data(image, juce::Image::BitmapData::readWrite);
+		size_t size = (size_t)kept.getWidth() * data.pixelStride;
+		if (dY > 0) {	// Lignes parcourues de bas en haut pour ne pas ecraser les lignes sources
+			for (int j = kept.getBottom() - 1; j >= kept.getY(); j--)
+				memmove(data.getPixelPointer(kept.getX(), j), data.getPixelPointer(kept.getX() - dX, j - dY), size);
+		}
+		else {
+			for (int j = kept.getY(); j < kept.getBottom(); j++)
+				memmove(data.getPixelPointer(kept.getX(), j), data.getPixelPointer(kept.getX() - dX, j - dY), size);
+		}
+	}
+	region.subtract(kept);
+	for (const juce::Rectangle<int>& r : region)
+		image.clear(r, background);
+	return region;
+}
+
+//==============================================================================
+// Preparation des images : en cas de simple deplacement de la vue, les images
+// raster et MNT completes sont decalees et seules les bandes decouvertes sont lues
+//==============================================================================
 void MapThread::PrepareImages(bool totalUpdate, int dX, int dY)
 {
+	bool shift = (!totalUpdate) && ((dX != 0) || (dY != 0));
 	if (m_bRaster) {
-		m_Raster.clear(m_Raster.getBounds(), juce::Colour(0xFFFFFFFF));
+		if (shift && m_bRasterValid)
+			m_RasterRegion = ShiftImage(m_Raster, dX, dY, juce::Colour(0xFFFFFFFF));
+		else {
+			m_Raster.clear(m_Raster.getBounds(), juce::Colour(0xFFFFFFFF));
+			m_RasterRegion = juce::RectangleList<int>(m_Raster.getBounds());
+		}
 		m_bRasterDone = false;
 	}
 	if (m_bDtm) {
-		m_Dtm.clear(m_Dtm.getBounds());
-		m_RawDtm.clear(m_RawDtm.getBounds());
+		if (shift && m_bDtmValid) {
+			m_DtmRegion = ShiftImage(m_RawDtm, dX, dY, juce::Colour());
+			ShiftImage(m_Dtm, dX, dY, juce::Colour());
+		}
+		else {
+			m_Dtm.clear(m_Dtm.getBounds());
+			m_RawDtm.clear(m_RawDtm.getBounds());
+			m_DtmRegion = juce::RectangleList<int>(m_Dtm.getBounds());
+		}
 		m_bRasterDone = false;
 	}
 	if (m_bOverlay)
@@ -91,21 +306,51 @@ void MapThread::PrepareImages(bool totalUpdate, int dX, int dY)
 	}
 }
 
-void MapThread::SetWorld(const double& X0, const double& Y0, const double& scale, const int& W, const int& H, bool force_vector)
+//==============================================================================
+// Fixe la vue. En mode tuiles, l'origine est calee sur la grille des pixels pour
+// que les tuiles, les rasters et la selection soient dessines avec la meme origine
+//==============================================================================
+void MapThread::SetWorld(const double& viewX0, const double& viewY0, const double& scale, const int& W, const int& H, bool force_vector)
 {
+	double X0 = viewX0, Y0 = viewY0;
+	if (m_bTiles) {
+		X0 = round(viewX0 / scale) * scale;
+		Y0 = round(viewY0 / scale) * scale;
+	}
 	bool totalUpdate = force_vector;
 	if (scale != m_dScale) totalUpdate = true;
 	if ((W != m_Vector.getWidth())||(H != m_Vector.getHeight())) totalUpdate = true;
 	int dX = round((m_dX0 - X0) / m_dScale), dY = round((Y0 - m_dY0) / m_dScale);
+	if ((scale != m_dScale) || (dX != 0) || (dY != 0)) {	// Les images non redessinees ne correspondent plus a la vue
+		if (!m_bRaster) m_bRasterValid = false;
+		if (!m_bDtm) m_bDtmValid = false;
+	}
 	PrepareImages(totalUpdate, dX, dY);
 	
 	m_dX0 = X0;
 	m_dY0 = Y0; 
 	m_dScale = scale;
+	m_Renderer.SetWorld(X0, Y0, scale);
 	SetDimension(W, H);
 	m_Env = OGREnvelope();
 	m_Env.Merge(m_dX0, m_dY0);
 	m_Env.Merge(m_dX0 + W * m_dScale, m_dY0 - H * m_dScale);
+	if (m_bVector)
+		PublishVector(true);
+}
+
+//==============================================================================
+// Publication de l'image vectorielle : le thread de dessin travaille dans
+// m_Vector et MapView::paint lit une copie echangee de maniere atomique
+//==============================================================================
+void MapThread::PublishVector(bool force, juce::uint32 delay)
+{
+	juce::uint32 time = juce::Time::getMillisecondCounter();
+	if ((!force) && (time - m_nLastPublish < delay))
+		return;
+	std::shared_ptr<juce::Image> frame = std::make_shared<juce::Image>(m_Vector.createCopy());
+	std::atomic_store(&m_VectorFront, frame);
+	m_nLastPublish = time;
 }
 
 void MapThread::run()
@@ -116,6 +361,7 @@ void MapThread::run()
 	// Affichage des couches raster
 	if (m_bRaster) {
 		m_bRasterDone = false;
+		m_bRasterValid = false;
 		for (int i = 0; i < m_Base->GetRasterLayerCount(); i++) {
 			GeoBase::RasterLayer* poLayer = m_Base->GetRasterLayer(i);
 			if (poLayer == nullptr)
@@ -123,10 +369,12 @@ void MapThread::run()
 			if (poLayer->Visible)
 				DrawLayer(poLayer);
 		}
+		m_bRasterValid = !threadShouldExit();
 	}
 	// Affichage des couches MNT
 	if (m_bDtm) {
 		m_bRasterDone = false;
+		m_bDtmValid = false;
 		bool flag = false;
 		for (int i = 0; i < m_Base->GetDtmLayerCount(); i++) {
 			GeoBase::RasterLayer* poLayer = m_Base->GetDtmLayer(i);
@@ -135,24 +383,42 @@ void MapThread::run()
 			if (poLayer->Visible)
 				flag |= DrawLayer(poLayer, true);
 		}
-		if (flag) {
+		if (flag) {	// L'estompage des pixels voisins des bandes lues depend aussi des nouvelles altitudes
 			DtmShader shader(m_dScale);
-			shader.ConvertImage(&m_RawDtm, &m_Dtm);
+			for (const juce::Rectangle<int>& r : m_DtmRegion)
+				shader.ConvertImage(&m_RawDtm, &m_Dtm, r.expanded(1));
 		}
+		m_bDtmValid = !threadShouldExit();
 	}
 	m_bRasterDone = true;
 	// Affichage des couches vectorielles
 	if (m_bVector) {
 		//m_Vector.clear(m_Vector.getBounds());
+		m_Renderer.SetClip(m_ClipVector);
+		std::vector<GeoBase::VectorLayer*> layers;
 		for (int i = 0; i < m_Base->GetVectorLayerCount(); i++) {
 			GeoBase::VectorLayer* poLayer = m_Base->GetVectorLayer(i);
 			if (poLayer == nullptr)
 				continue;
 			if (!poLayer->m_Repres.Visible)
 				continue;
+			if (!poLayer->Materialized())	// Index en cours de construction par le thread de chargement
+				continue;
+			std::lock_guard<std::mutex> lock(poLayer->Mutex());
 			poLayer->SetSpatialFilterRect(m_Env, &m_SpatialRef);
-			DrawLayer(poLayer);
+			layers.push_back(poLayer);
 		}
+		if (m_bTiles)
+			DrawVectorTiles(layers);
+		else if (m_bProgressive)
+			DrawVectorProgressive(layers);
+		else if (m_bParallel)
+			DrawVectorLayers(layers);
+		else {
+			for (size_t i = 0; i < layers.size(); i++)
+				DrawLayer(layers[i]);
+		}
+		PublishVector(true);
 	}
 	// Affichage de la selection
 	if (m_bOverlay)
@@ -168,7 +434,9 @@ bool MapThread::Draw(juce::Graphics& g, int x0, int y0)
 	g.drawImageAt(m_Raster, x0, y0);
 	//g.setOpacity(0.5f);
 	g.drawImageAt(m_Dtm, x0, y0);
-	g.drawImageAt(m_Vector, x0, y0);
+	std::shared_ptr<juce::Image> vector = std::atomic_load(&m_VectorFront);
+	if (vector != nullptr)
+		g.drawImageAt(*vector, x0, y0);
 	g.drawImageAt(m_Overlay, x0, y0);
 	return true;
 }
@@ -178,161 +446,228 @@ bool MapThread::Draw(juce::Graphics& g, int x0, int y0)
 //==============================================================================
 void MapThread::DrawLayer(GeoBase::VectorLayer* poLayer)
 {
-	poLayer->ResetReading();
-	OGREnvelope env;
-	OGRCoordinateTransformation* poTransfo = OGRCreateCoordinateTransformation(poLayer->SpatialRef(), &m_SpatialRef);
-	if (poTransfo == nullptr)
+	GeoBase::Transformation* transfo = GeoBase::Transformation::Get(poLayer->SpatialRef(), &m_SpatialRef);
+	if (transfo == nullptr)
 		return;
-	do {
-		const juce::MessageManagerLock mml(Thread::getCurrentThread());
-		if (!mml.lockWasGained())  // if something is trying to kill this job, the lock
-			return;
-		juce::Graphics g(m_Vector);
-		g.excludeClipRegion(m_ClipVector);
-
-		for (int i = 0; i < 100; i++) {
-			if (threadShouldExit())
-				return;
-			OGRFeature* poFeature = poLayer->GetNextFeature();
-			if (poFeature == nullptr) {
-				delete poTransfo;
-				return;
-			}
-
-			m_Path.clear();
-			m_bFill = false;
-			g.setColour(juce::Colour(poLayer->m_Repres.PenColor));
-			OGRGeometry* poGeom = poFeature->GetGeometryRef();
-			poGeom->transform(poTransfo);
-			poGeom->getEnvelope(&env);
-			juce::Rectangle<int> frame = juce::Rectangle<int>((int)round((env.MinX - m_dX0) / m_dScale), (int)round((m_dY0 - env.MaxY) / m_dScale),
-				(int)round((env.MaxX - env.MinX) / m_dScale), (int)round((env.MaxY - env.MinY) / m_dScale));
-			if (!m_ClipVector.contains(frame)) {
-				if ((frame.getWidth() < 2) && (frame.getHeight() < 2) && (poGeom->getDimension() > 0)) {
-					g.drawRect(frame, 2.);
-				}
-				else {
-					DrawGeometry(poGeom);
-					g.strokePath(m_Path, juce::PathStrokeType(poLayer->m_Repres.PenSize, juce::PathStrokeType::beveled));
-					if (m_bFill) {
-						g.setFillType(juce::FillType(juce::Colour(poLayer->m_Repres.FillColor)));
-						g.fillPath(m_Path);
-					}
-				}
-			}
-
-			OGRFeature::DestroyFeature(poFeature);
-			m_nNumObjects++;
+	{
+		std::lock_guard<std::mutex> lock(poLayer->Mutex());
+		poLayer->ResetReading();
+	}
+	juce::Graphics g(m_Vector);
+	g.excludeClipRegion(m_ClipVector);
+	bool more = true;
+	while ((more) && (!threadShouldExit())) {
+		{
+			std::lock_guard<std::mutex> lock(poLayer->Mutex());
+			m_Renderer.ResetNumObjects();
+			more = m_Renderer.DrawFeatures(poLayer, g, transfo, 100);
+			m_nNumObjects += m_Renderer.NumObjects();
 		}
-	} while (!threadShouldExit());
-	delete poTransfo;
+		PublishVector(false);
+	}
+	m_Renderer.Flush(g);
 }
 
 //==============================================================================
-// Dessin des geometries OGR
+// Dessin des layers vectoriels en parallele : chaque layer est dessine dans sa
+// propre image, puis les images sont composees dans l'ordre des layers
+// Le nombre de layers en cours est borne par le nombre de threads : au plus
+// autant d'images de layers sont en memoire en meme temps
 //==============================================================================
-void MapThread::DrawGeometry(const OGRGeometry* poGeom)
+void MapThread::DrawVectorLayers(const std::vector<GeoBase::VectorLayer*>& layers)
 {
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbPoint)
-		return DrawPoint(poGeom);
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbPolygon)
-		DrawPolygon(poGeom);
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiPolygon)
-		DrawMultiPolygon(poGeom);
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbLineString)
-		DrawLineString(poGeom);
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiLineString)
-		DrawMultiLineString(poGeom);
-	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiPoint)
-		DrawMultiPoint(poGeom);
-}
+	if (m_Pool == nullptr)
+		m_Pool.reset(new juce::ThreadPool(juce::jmax(1, juce::SystemStats::getNumCpus())));
+	const size_t maxJobs = (size_t)juce::jmax(1, m_Pool->getNumThreads());
+	std::vector<VectorLayerJob*> jobs(layers.size(), nullptr);
+	size_t next = 0;	// Prochain layer a lancer
+	for (size_t i = 0; i < jobs.size(); i++) {
+		for (; (next < jobs.size()) && (next < i + maxJobs); next++) {
+			jobs[next] = new VectorLayerJob(layers[next], m_Vector.getWidth(), m_Vector.getHeight(), m_dX0, m_dY0, m_dScale, m_ClipVector, m_bBatch);
+			m_Pool->addJob(jobs[next], false);
+		}
+		while (!m_Pool->waitForJobToFinish(jobs[i], 20)) {
+			if (threadShouldExit())
+				break;
+		}
+		if (threadShouldExit())
+			break;
+		{
+			juce::Graphics g(m_Vector);
+			g.drawImageAt(jobs[i]->Image(), 0, 0);
+		}
+		m_nNumObjects += jobs[i]->NumObjects();
+		jobs[i]->Image() = juce::Image();
+		PublishVector(false);
+	}
 
-void MapThread::DrawPoint(const OGRGeometry* poGeom)
-{
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbPoint)
-		return;
-	const OGRPoint* poPoint = poGeom->toPoint();
-	double X = (poPoint->getX() - m_dX0) / m_dScale, Y = (m_dY0 - poPoint->getY()) / m_dScale;
-	double d = 3;
-	m_Path.startNewSubPath(X, Y);
-	m_Path.addEllipse(X - d, Y - d, 2 * d, 2 * d);
+	while (!m_Pool->removeAllJobs(true, 1000))
+		;
+	for (size_t i = 0; i < jobs.size(); i++)
+		delete jobs[i];
 }
 
-void MapThread::DrawPolygon(const OGRGeometry* poGeom)
-{
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbPolygon)
-		return;
-	m_bFill = true;
-	const OGRPolygon* poPolygon = poGeom->toPolygon();
-	const OGRCurve* poCurve = poPolygon->getExteriorRingCurve();
-	DrawCurve(poCurve);
-	for (int i = 0; i < poPolygon->getNumInteriorRings(); i++) {
-		poCurve = poPolygon->getInteriorRingCurve(i);
-		DrawCurve(poCurve);
-	}
-}
-void MapThread::DrawMultiPolygon(const OGRGeometry* poGeom)
+//==============================================================================
+// Dessin progressif des layers vectoriels : chaque layer est dessine dans sa
+// propre image. Les gros objets sont dessines pendant la lecture, en partant du
+// centre de la vue, puis une seconde passe dessine les autres dans le meme ordre.
+// Les images sont composees dans l'ordre des layers et publiees toutes les 50 ms
+//==============================================================================
+void MapThread::DrawVectorProgressive(const std::vector<GeoBase::VectorLayer*>& layers)
 {
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiPolygon)
-		return;
-	m_bFill = true;
-	const OGRMultiPolygon* poMPolygon = poGeom->toMultiPolygon();
-	for (int i = 0; i < poMPolygon->getNumGeometries(); i++)
-		DrawPolygon(poMPolygon->getGeometryRef(i));
-}
+	const double coarseSize = 16.;	// Taille minimum (pixels) des objets de la passe grossiere
+	const int W = m_Vector.getWidth(), H = m_Vector.getHeight();
+	juce::Image base = m_Vector.createCopy();	// Contenu deja dessine (dans m_ClipVector)
 
-void MapThread::DrawLineString(const OGRGeometry* poGeom)
-{
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbLineString)
-		return;
-	const OGRLineString* poLine = poGeom->toLineString();
-	if (!AllocPoints(poLine->getNumPoints()))
-		return;
-	poLine->getPoints(m_Pt, 2 * sizeof(double), &m_Pt[1], 2 * sizeof(double));
-	m_Path.startNewSubPath((m_Pt[0] - m_dX0)/m_dScale, (m_dY0 - m_Pt[1])/m_dScale);
-	for (int i = 1; i < poLine->getNumPoints(); i++)
-		m_Path.lineTo((m_Pt[2 * i] - m_dX0)/m_dScale, (m_dY0 - m_Pt[2 * i + 1])/m_dScale);
-}
+	std::vector<ProgressiveLayer> P;
+	for (size_t i = 0; i < layers.size(); i++) {
+		GeoBase::VectorLayer* poLayer = layers[i];
+		ProgressiveLayer p;
+		p.Layer = poLayer;
+		p.Index = 0;
+		p.More[0] = p.More[1] = true;
+		std::lock_guard<std::mutex> lock(poLayer->Mutex());
+		p.Transfo = GeoBase::Transformation::Get(poLayer->SpatialRef(), &m_SpatialRef);
+		if (p.Transfo == nullptr)
+			continue;
+		p.Image = juce::Image(juce::Image::PixelFormat::ARGB, W, H, true);
+		p.Stream = poLayer->FastSpatialFilter();
+		// Centre de la vue et taille du pixel dans le systeme du layer
+		OGREnvelope view = GeoBase::ConvertEnvelop(m_Env, &m_SpatialRef, poLayer->SpatialRef());
+		p.Cx = (view.MinX + view.MaxX) * 0.5;
+		p.Cy = (view.MinY + view.MaxY) * 0.5;
+		p.MinSize = coarseSize * (view.MaxX - view.MinX) / W;
+		poLayer->ResetReadingFrom(p.Cx, p.Cy);
+		P.push_back(p);
+	}
 
-void MapThread::DrawCurve(const OGRCurve* poCurve)
-{
-	if (wkbFlatten(poCurve->getGeometryType()) == wkbLineString)
-		return DrawLineString(poCurve);
-	if (strcmp(poCurve->getGeometryName(), "LINEARRING") == 0) {
-		const OGRLinearRing* poRing = poCurve->toLinearRing();
-		return DrawLinearRing(poRing);
+	m_nLastPublish = juce::Time::getMillisecondCounter();
+	for (int pass = 0; pass < 2; pass++) {
+		bool more = true;
+		while ((more) && (!threadShouldExit())) {	// Tour de role entre les layers
+			more = false;
+			for (size_t i = 0; i < P.size(); i++) {
+				ProgressiveLayer& p = P[i];
+				if (!p.More[pass])
+					continue;
+				juce::Graphics g(p.Image);
+				g.excludeClipRegion(m_ClipVector);
+				{
+					std::lock_guard<std::mutex> lock(p.Layer->Mutex());
+					m_Renderer.ResetNumObjects();
+					if (pass == 0)
+						p.More[0] = ScanProgressive(p, m_Renderer, g, 500);
+					else
+						p.More[1] = m_Renderer.DrawFeatures(p.Layer, g, p.Transfo, p.Pass, p.Index, 100);
+					m_nNumObjects += m_Renderer.NumObjects();
+				}
+				m_Renderer.Flush(g);
+				more |= p.More[pass];
+				if (threadShouldExit())
+					return;
+				if (juce::Time::getMillisecondCounter() - m_nLastPublish >= 50) {
+					ComposeLayers(m_Vector, base, P);
+					PublishVector(false, 50);
+				}
+			}
+		}
 	}
+	if (!threadShouldExit())
+		ComposeLayers(m_Vector, base, P);
 }
 
-void MapThread::DrawLinearRing(const OGRLinearRing* poRing)
+//==============================================================================
+// Dessin des layers vectoriels a partir des tuiles en cache : seules les tuiles
+// absentes sont dessinees, puis les tuiles sont composees dans l'ordre des layers
+//==============================================================================
+void MapThread::DrawVectorTiles(const std::vector<GeoBase::VectorLayer*>& layers)
 {
-	for (int i = 0; i < poRing->getNumPoints(); i++);
+	const int T = TileCache::TileSize;
+	juce::int64 level = TileCache::Level(m_dScale);
+	// Origine de la vue en pixels dans la grille des tuiles (entiere : voir SetWorld)
+	juce::int64 u0 = (juce::int64)round(m_dX0 / m_dScale), v0 = (juce::int64)round(-m_dY0 / m_dScale);
+	int tx0 = (int)floor((double)u0 / T), tx1 = (int)floor((double)(u0 + m_Vector.getWidth() - 1) / T);
+	int ty0 = (int)floor((double)v0 / T), ty1 = (int)floor((double)(v0 + m_Vector.getHeight() - 1) / T);
 
-	if (!AllocPoints(poRing->getNumPoints()))
-		return;
-	poRing->getPoints(m_Pt, 2 * sizeof(double), &m_Pt[1], 2 * sizeof(double));
-	m_Path.startNewSubPath((m_Pt[0] - m_dX0) / m_dScale, (m_dY0 - m_Pt[1]) / m_dScale);
-	for (int i = 1; i < poRing->getNumPoints(); i++)
-		m_Path.lineTo((m_Pt[2 * i] - m_dX0) / m_dScale, (m_dY0 - m_Pt[2 * i + 1]) / m_dScale);
-	m_Path.closeSubPath();
+	m_Vector.clear(m_Vector.getBounds());
+	for (size_t i = 0; i < layers.size(); i++) {
+		GeoBase::VectorLayer* poLayer = layers[i];
+		GeoBase::Transformation* transfo = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(poLayer->Mutex());
+			transfo = GeoBase::Transformation::Get(poLayer->SpatialRef(), &m_SpatialRef);
+		}
+		if (transfo == nullptr)
+			continue;
+		TileCache::Key key;
+		key.Level = level;
+		key.Layer = poLayer->Id();
+		key.Style = TileCache::StyleHash(poLayer->m_Repres, m_bBatch);
+		for (int ty = ty0; ty <= ty1; ty++) {
+			for (int tx = tx0; tx <= tx1; tx++) {
+				key.X = tx;
+				key.Y = ty;
+				juce::Image tile = m_Tiles.Find(key);
+				if (!tile.isValid()) {
+					tile = DrawTile(poLayer, transfo, tx, ty);
+					if (threadShouldExit())
+						break;
+					m_Tiles.Insert(key, tile);
+				}
+				juce::Graphics g(m_Vector);
+				g.drawImageAt(tile, (int)(tx * (juce::int64)T - u0), (int)(ty * (juce::int64)T - v0));
+			}
+			if (threadShouldExit())
+				break;
+		}
+		if (threadShouldExit())
+			break;
+		PublishVector(false);
+	}
+	m_Renderer.SetWorld(m_dX0, m_dY0, m_dScale);
 }
 
-void MapThread::DrawMultiLineString(const OGRGeometry* poGeom)
+//==============================================================================
+// Dessin d'une tuile d'un layer vectoriel
+// Les features sont recherches avec une marge pour les traits et les symboles qui
+// debordent ; seuls ceux dont l'enveloppe commence dans la tuile sont comptes
+//==============================================================================
+juce::Image MapThread::DrawTile(GeoBase::VectorLayer* poLayer, GeoBase::Transformation* transfo, int tx, int ty)
 {
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiLineString)
-		return;
-	const OGRMultiLineString* poMLine = poGeom->toMultiLineString();
-	for (int i = 0; i < poMLine->getNumGeometries(); i++)
-		DrawLineString(poMLine->getGeometryRef(i));
-}
+	const int T = TileCache::TileSize;
+	double X0 = tx * T * m_dScale, Y0 = -ty * T * m_dScale;
+	double margin = (juce::jmax(poLayer->m_Repres.PenSize, poLayer->m_Repres.SymbolSize) * 0.5 + 1.) * m_dScale;
+	OGREnvelope tileEnv;
+	tileEnv.MinX = X0;
+	tileEnv.MaxX = X0 + T * m_dScale;
+	tileEnv.MinY = Y0 - T * m_dScale;
+	tileEnv.MaxY = Y0;
+	OGREnvelope env = tileEnv;
+	env.MinX -= margin;
+	env.MaxX += margin;
+	env.MinY -= margin;
+	env.MaxY += margin;
 
-void MapThread::DrawMultiPoint(const OGRGeometry* poGeom)
-{
-	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiPoint)
-		return;
-	const OGRMultiPoint* poMPoint = poGeom->toMultiPoint();
-	for (int i = 0; i < poMPoint->getNumGeometries(); i++)
-		DrawPoint(poMPoint->getGeometryRef(i));
+	juce::Image tile(juce::Image::PixelFormat::ARGB, T, T, true);
+	m_Renderer.SetWorld(X0, Y0, m_dScale);
+	m_Renderer.SetClip(juce::Rectangle<int>());
+	m_Renderer.SetCountEnvelope(tileEnv);
+	{
+		std::lock_guard<std::mutex> lock(poLayer->Mutex());
+		poLayer->SetSpatialFilterRect(env, &m_SpatialRef);
+		poLayer->ResetReading();
+	}
+	juce::Graphics g(tile);
+	bool more = true;
+	while ((more) && (!threadShouldExit())) {
+		std::lock_guard<std::mutex> lock(poLayer->Mutex());
+		m_Renderer.ResetNumObjects();
+		more = m_Renderer.DrawFeatures(poLayer, g, transfo, 100);
+		m_nNumObjects += m_Renderer.NumObjects();
+	}
+	m_Renderer.Flush(g);
+	m_Renderer.SetCountEnvelope(OGREnvelope());
+	return tile;
 }
 
 //==============================================================================
@@ -347,27 +682,33 @@ void MapThread::DrawSelection()
 
 	OGREnvelope env;
 	OGRLayer* lastLayer = nullptr;
-	OGRCoordinateTransformation* poTransfo = nullptr;
+	GeoBase::Transformation* transfo = nullptr;
 	for (size_t i = 0; i < m_Base->GetSelectionCount(); i++) {
-		m_Path.clear();
+		m_Renderer.ClearPath();
 		GeoBase::Feature feature = m_Base->GetSelection(i);
-		OGRLayer* poLayer = m_Base->GetOGRLayer(feature.IdLayer());
+		GeoBase::VectorLayer* geoLayer = m_Base->GetVectorLayerId(feature.IdLayer());
+		if (geoLayer == nullptr)
+			continue;
+		OGRLayer* poLayer = geoLayer->GetOGRLayer();
 		if (poLayer == nullptr)
 			continue;
 		if (lastLayer != poLayer) {
 			lastLayer = poLayer;
-			delete poTransfo;
-			poTransfo = OGRCreateCoordinateTransformation(poLayer->GetSpatialRef(), &m_SpatialRef);
-			if (poTransfo == nullptr) {
+			transfo = GeoBase::Transformation::Get(poLayer->GetSpatialRef(), &m_SpatialRef);
+			if (transfo == nullptr) {
 				lastLayer = nullptr;
 				continue;
 			}
 		}
-		OGRFeature* poFeature = poLayer->GetFeature(feature.Id());
+		OGRFeature* poFeature = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(geoLayer->Mutex());
+			poFeature = poLayer->GetFeature(feature.Id());
+		}
 		if (poFeature == nullptr)
 			continue;	
 		OGRGeometry* poGeom = poFeature->GetGeometryRef();
-		poGeom->transform(poTransfo);
+		transfo->Transform(poGeom);
 		poGeom->getEnvelope(&env);
 		if (m_Env.Intersects(env)) {
 			int W = (int)round(env.MaxX - env.MinX) / m_dScale;
@@ -380,10 +721,10 @@ void MapThread::DrawSelection()
 				g.drawRect((int)floor((env.MinX - m_dX0) / m_dScale) - 2, (int)floor((m_dY0 - env.MaxY) / m_dScale) - 2, W + 4, H + 4);
 			}
 			else {
-				DrawGeometry(poGeom);
-				juce::Path::Iterator iter(m_Path);
+				m_Renderer.DrawGeometry(poGeom);
+				juce::Path::Iterator iter(m_Renderer.GetPath());
 				int numPoint = 0;
-				if (!m_bFill) 
+				if (!m_Renderer.NeedFill()) 
 					numPoint = 1;
 				bool needText = true;
 				float dim = std::min<float>(std::max<float>((float)(4.f / m_dScale), 2.f), 4.f);
@@ -395,7 +736,7 @@ void MapThread::DrawSelection()
 					g.setColour(juce::Colours::white);
 					g.drawRect(iter.x1 - dim + 1, iter.y1 - dim + 1, 2.f * dim - 2, 2.f * dim - 2);
 					if (needText) {
-						if ((!m_bFill) || (iter.elementType != juce::Path::Iterator::startNewSubPath)) {
+						if ((!m_Renderer.NeedFill()) || (iter.elementType != juce::Path::Iterator::startNewSubPath)) {
 							g.drawSingleLineText(juce::String(numPoint), iter.x1 + 4, iter.y1);
 							g.drawSingleLineText(juce::String(numPoint), iter.x1 + 6, iter.y1);
 							g.drawSingleLineText(juce::String(numPoint), iter.x1 + 5, iter.y1+1);
@@ -409,28 +750,67 @@ void MapThread::DrawSelection()
 			}
 		}
 		OGRFeature::DestroyFeature(poFeature);
-		if (threadShouldExit()) {
-			delete poTransfo;
+		m_Renderer.ClearPath();	// Le path ne doit pas etre dessine par le prochain Flush
+		if (threadShouldExit())
 			return;
-		}
 	}
-	delete poTransfo;
 }
 
 //==============================================================================
-// Dessin des layers raster
+// Emprise terrain d'une zone de la vue
+//==============================================================================
+OGREnvelope MapThread::PixelEnvelope(const juce::Rectangle<int>& area)
+{
+	OGREnvelope env;
+	env.MinX = m_dX0 + area.getX() * m_dScale;
+	env.MaxX = m_dX0 + area.getRight() * m_dScale;
+	env.MaxY = m_dY0 - area.getY() * m_dScale;
+	env.MinY = m_dY0 - area.getBottom() * m_dScale;
+	return env;
+}
+
+//==============================================================================
+// Dataset a lire pour un raster depuis le thread de dessin : le dataset de la base,
+// ou un dataset emprunte au pool pour un raster ouvert a la demande
+//==============================================================================
+static GDALDataset* RasterSource(GeoBase::Raster* raster, DatasetPool::Lease& lease)
+{
+	if (raster->Dataset() != nullptr)
+		return raster->Dataset();
+	if (!raster->File().empty()) {
+		lease = DatasetPool::Instance().Acquire(raster->File(), GDAL_OF_RASTER | GDAL_OF_READONLY);
+		if (lease.Dataset() != nullptr)
+			return lease.Dataset();
+	}
+	return raster->Dataset();
+}
+
+//==============================================================================
+// Dessin d'un layer raster dans les zones de la vue a lire
+// Les rasters de chaque zone sont trouves avec l'index des emprises du layer
 //==============================================================================
 bool MapThread::DrawLayer(GeoBase::RasterLayer* layer, bool dtm)
 {
 	if (!m_Env.Intersects(layer->Envelope()))
 		return false;
+	std::vector<std::pair<int, juce::Rectangle<int> > > reads;	// Raster et zone de la vue
+	std::vector<int> rasters;
+	for (const juce::Rectangle<int>& r : (dtm ? m_DtmRegion : m_RasterRegion)) {
+		layer->Search(PixelEnvelope(r), rasters);
+		for (size_t i = 0; i < rasters.size(); i++)
+			reads.push_back(std::make_pair(rasters[i], r));
+	}
+	if ((!dtm) && (reads.size() > 1))
+		return DrawRasters(layer, reads);
 	bool flag = false;
-	for (int i = 0; i < layer->GetRasterCount(); i++) {
-		if (m_Env.Intersects(layer->GetRasterEnvelope(i)))
-			if (dtm)
-				flag |= DrawDtm(layer->GetRasterDataset(i), layer->Opacity());
-			else
-				flag |= DrawRaster(layer->GetRasterDataset(i), layer->Opacity());
+	for (size_t i = 0; i < reads.size(); i++) {
+		GeoBase::Raster* raster = layer->GetRaster(reads[i].first);
+		DatasetPool::Lease lease;
+		GDALDataset* poDataset = RasterSource(raster, lease);
+		if (dtm)
+			flag |= DrawDtm(poDataset, reads[i].second);
+		else
+			flag |= DrawRaster(poDataset, raster, reads[i].second, layer->Opacity());
 		if (threadShouldExit())
 			return false;
 	}
@@ -438,10 +818,108 @@ bool MapThread::DrawLayer(GeoBase::RasterLayer* layer, bool dtm)
 }
 
 //==============================================================================
-// Dessin d'un dataset raster
+// RasterReadJob : lecture d'un raster sur un handle propre au thread de travail.
+// Le dataset de la base n'est jamais lu par un job : si le pool ne fournit pas de
+// handle, le raster est lu ensuite par le thread de dessin (Deferred)
 //==============================================================================
-bool MapThread::PrepareRasterDraw(GDALDataset* poDataset, int& U0, int& V0, int& win, int& hin, int& nbBand, 
-																													int& R0, int& S0, int& wout, int& hout)
+class RasterReadJob : public juce::ThreadPoolJob {
+public:
+	RasterReadJob(MapThread* thread, GeoBase::Raster* raster, const juce::Rectangle<int>& area)
+		: juce::ThreadPoolJob("RasterReadJob")
+	{
+		m_Thread = thread; m_Raster = raster; m_Area = area;
+		m_nR0 = m_nS0 = 0;
+		m_bRead = m_bDeferred = false;
+	}
+
+	juce::Image& Image() { return m_Image; }
+	bool Read() { return m_bRead; }
+	bool Deferred() { return m_bDeferred; }
+	int R0() { return m_nR0; }
+	int S0() { return m_nS0; }
+	const juce::Rectangle<int>& Area() { return m_Area; }
+
+	JobStatus runJob() override
+	{
+		if (shouldExit())
+			return jobHasFinished;
+		DatasetPool::Lease lease = DatasetPool::Instance().Acquire(m_Raster->File(), GDAL_OF_RASTER | GDAL_OF_READONLY);
+		if (lease.Dataset() == nullptr) {
+			m_bDeferred = true;
+			return jobHasFinished;
+		}
+		m_bRead = m_Thread->ReadRaster(m_Raster, lease.Dataset(), m_Area, m_Image, m_nR0, m_nS0);
+		return jobHasFinished;
+	}
+
+private:
+	MapThread*			m_Thread;
+	GeoBase::Raster*	m_Raster;	// Raster lu : cle du cache de tuiles
+	juce::Rectangle<int> m_Area;	// Zone de la vue a lire
+	juce::Image		m_Image;
+	int						m_nR0, m_nS0;
+	bool					m_bRead;
+	bool					m_bDeferred;	// Pas de handle du pool : lecture par le thread de dessin
+};
+
+//==============================================================================
+// Lecture en parallele des datasets d'un layer raster, puis melange dans
+// l'ordre du layer avec son opacite. Les rasters qui ne peuvent pas etre rouverts
+// sont lus par le thread de dessin, dans l'ordre du layer : leur dataset n'est
+// jamais lu par deux threads
+//==============================================================================
+bool MapThread::DrawRasters(GeoBase::RasterLayer* layer, const std::vector<std::pair<int, juce::Rectangle<int> > >& reads)
+{
+	if (m_Pool == nullptr)
+		m_Pool.reset(new juce::ThreadPool(juce::jmax(1, juce::SystemStats::getNumCpus())));
+	std::vector<RasterReadJob*> jobs(reads.size(), nullptr);
+	for (size_t i = 0; i < reads.size(); i++) {
+		GeoBase::Raster* raster = layer->GetRaster(reads[i].first);
+		if (raster->File().empty())
+			continue;
+		jobs[i] = new RasterReadJob(this, raster, reads[i].second);
+		m_Pool->addJob(jobs[i], false);
+	}
+
+	bool flag = false;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		if (jobs[i] != nullptr) {
+			while (!m_Pool->waitForJobToFinish(jobs[i], 20)) {
+				if (threadShouldExit())
+					break;
+			}
+		}
+		if (threadShouldExit())
+			break;
+		if ((jobs[i] == nullptr) || (jobs[i]->Deferred())) {
+			GeoBase::Raster* raster = layer->GetRaster(reads[i].first);
+			DatasetPool::Lease lease;
+			flag |= DrawRaster(RasterSource(raster, lease), raster, reads[i].second, layer->Opacity());
+			continue;
+		}
+		if (jobs[i]->Read()) {
+			BlendRaster(jobs[i]->Image(), jobs[i]->R0(), jobs[i]->S0(), jobs[i]->Area(), layer->Opacity());
+			flag = true;
+		}
+		jobs[i]->Image() = juce::Image();
+	}
+
+	while (!m_Pool->removeAllJobs(true, 1000))
+		;
+	for (size_t i = 0; i < jobs.size(); i++)
+		delete jobs[i];
+	if (threadShouldExit())
+		return false;
+	return flag;
+}
+
+//==============================================================================
+// Preparation de la lecture d'un dataset raster pour la zone area de la vue
+// La fenetre lue deborde d'au plus un pixel du dataset pour couvrir toute la zone :
+// l'image resultat est decoupee a la zone lors du dessin
+//==============================================================================
+bool MapThread::PrepareRasterDraw(GDALDataset* poDataset, const juce::Rectangle<int>& area, int& U0, int& V0, int& win, int& hin,
+																	int& nbBand, int& R0, int& S0, int& wout, int& hout)
 {
 	if (poDataset == nullptr)
 		return false;
@@ -457,10 +935,11 @@ bool MapThread::PrepareRasterDraw(GDALDataset* poDataset, int& U0, int& V0, int&
 	double gsd = transfo[1];
 	if (Y0 < 1) Y0 = H;
 	// Zone pixel dans l'image
-	U0 = (int)round((m_Env.MinX - X0) / gsd);
-	V0 = (int)round((Y0 - m_Env.MaxY) / gsd);
-	int U1 = (int)round((m_Env.MaxX - X0) / gsd);
-	int V1 = (int)round((Y0 - m_Env.MinY) / gsd);
+	OGREnvelope env = PixelEnvelope(area);
+	U0 = (int)floor((env.MinX - X0) / gsd);
+	V0 = (int)floor((Y0 - env.MaxY) / gsd);
+	int U1 = (int)ceil((env.MaxX - X0) / gsd);
+	int V1 = (int)ceil((Y0 - env.MinY) / gsd);
 	if (U0 < 0) U0 = 0;
 	if (V0 < 0) V0 = 0;
 	if (U1 > W) U1 = W;
@@ -481,60 +960,179 @@ bool MapThread::PrepareRasterDraw(GDALDataset* poDataset, int& U0, int& V0, int&
 	return true;
 }
 
+//==============================================================================
+// Choix de l'apercu pour lire la fenetre (U0, V0, win, hin) en (wout, hout) : le plus
+// reduit dont la resolution reste au moins celle de la sortie. La fenetre exacte dans
+// la grille de l'apercu est donnee dans arg. Renvoie -1 pour la pleine resolution
+//==============================================================================
+static int ChooseOverview(GDALDataset* poDataset, int U0, int V0, int win, int hin, int wout, int hout, GDALRasterIOExtraArg& arg)
+{
+	INIT_RASTERIO_EXTRA_ARG(arg);
+	GDALRasterBand* band = poDataset->GetRasterBand(1);
+	if ((band == nullptr) || (wout < 1) || (hout < 1))
+		return -1;
+	double factor = std::min((double)win / wout, (double)hin / hout);	// Sous-echantillonnage demande
+	int W = band->GetXSize(), H = band->GetYSize();
+	int level = -1;
+	double bestFactor = 1.;
+	for (int k = 0; k < band->GetOverviewCount(); k++) {
+		GDALRasterBand* overview = band->GetOverview(k);
+		if ((overview == nullptr) || (overview->GetXSize() < 1) || (overview->GetYSize() < 1))
+			continue;
+		double ovFactor = (double)W / overview->GetXSize();
+		if ((ovFactor <= factor) && (ovFactor > bestFactor)) {
+			bestFactor = ovFactor;
+			level = k;
+		}
+	}
+	if (level < 0)
+		return -1;
+	GDALRasterBand* overview = band->GetOverview(level);
+	double rx = (double)overview->GetXSize() / W, ry = (double)overview->GetYSize() / H;
+	arg.bFloatingPointWindowValidity = TRUE;
+	arg.dfXOff = U0 * rx;
+	arg.dfYOff = V0 * ry;
+	arg.dfXSize = win * rx;
+	arg.dfYSize = hin * ry;
+	return level;
+}
+
+//==============================================================================
+// Fenetre entiere contenant la fenetre exacte d'un apercu
+//==============================================================================
+static void OverviewWindow(GDALRasterBand* overview, const GDALRasterIOExtraArg& arg, int& U0, int& V0, int& win, int& hin)
+{
+	U0 = (int)floor(arg.dfXOff);
+	V0 = (int)floor(arg.dfYOff);
+	int U1 = std::min(overview->GetXSize(), (int)ceil(arg.dfXOff + arg.dfXSize));
+	int V1 = std::min(overview->GetYSize(), (int)ceil(arg.dfYOff + arg.dfYSize));
+	win = std::max(1, U1 - U0);
+	hin = std::max(1, V1 - V0);
+}
+
+// Sous-echantillonnage maximal pour lequel les tuiles en cache sont utilisees : au-dela,
+// il faudrait decoder bien plus de pixels que la vue n'en affiche
+static const double MaxTileFactor = 2.;
+
+//==============================================================================
+// Composition de la fenetre (x0, y0, w, h) de la grille d'un apercu a partir des
+// tuiles decodees du cache pour ce raster, puis reechantillonnage dans image
+//==============================================================================
+static bool ComposeTiles(const void* raster, GDALDataset* poDataset, int level, double x0, double y0, double w, double h, juce::Image& image)
+{
+	GDALRasterBand* band = poDataset->GetRasterBand(1);
+	if ((band != nullptr) && (level >= 0))
+		band = band->GetOverview(level);
+	if ((band == nullptr) || (w <= 0.) || (h <= 0.))
+		return false;
+	int U0 = std::max(0, (int)floor(x0)), V0 = std::max(0, (int)floor(y0));
+	int U1 = std::min(band->GetXSize(), (int)ceil(x0 + w)), V1 = std::min(band->GetYSize(), (int)ceil(y0 + h));
+	if ((U1 <= U0) || (V1 <= V0))
+		return false;
+	juce::Image window(juce::Image::PixelFormat::RGB, U1 - U0, V1 - V0, true);
+	{
+		juce::Graphics g(window);
+		const int size = RasterCache::TileSize;
+		for (int ty = V0 / size; ty <= (V1 - 1) / size; ty++) {
+			for (int tx = U0 / size; tx <= (U1 - 1) / size; tx++) {
+				juce::Image tile = RasterCache::Instance().Tile(raster, poDataset, level, tx, ty);
+				if (!tile.isValid())
+					return false;
+				g.drawImageAt(tile, tx * size - U0, ty * size - V0);
+			}
+		}
+	}
+	juce::Graphics g(image);
+	g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);	// Plus proche voisin, comme RasterIO
+	g.drawImageTransformed(window, juce::AffineTransform::translation((float)(U0 - x0), (float)(V0 - y0))
+		.scaled((float)(image.getWidth() / w), (float)(image.getHeight() / h)));
+	return true;
+}
+
 //==============================================================================
 // Dessin d'un dataset raster
 //==============================================================================
-bool MapThread::DrawRaster(GDALDataset* poDataset, float opacity)
+bool MapThread::DrawRaster(GDALDataset* poDataset, const void* raster, const juce::Rectangle<int>& area, float opacity)
 {
-	int U0, V0, win, hin, R0, S0, wout, hout, nbBand;
-	if (!PrepareRasterDraw(poDataset, U0, V0, win, hin, nbBand, R0, S0, wout, hout))
+	juce::Image image;
+	int R0, S0;
+	if (!ReadRaster(raster, poDataset, area, image, R0, S0))
+		return false;
+	BlendRaster(image, R0, S0, area, opacity);
+	return true;
+}
+
+//==============================================================================
+// Lecture de la zone area de la vue dans un raster : image a placer en (R0, S0)
+// source est le handle lu, raster identifie le raster dans le cache de tuiles.
+// Peut etre appele depuis plusieurs threads pour des rasters differents
+//==============================================================================
+bool MapThread::ReadRaster(const void* raster, GDALDataset* source, const juce::Rectangle<int>& area, juce::Image& image, int& R0, int& S0)
+{
+	int U0, V0, win, hin, wout, hout, nbBand;
+	if (!PrepareRasterDraw(source, area, U0, V0, win, hin, nbBand, R0, S0, wout, hout))
 		return false;
 	
 	//if (nbBand == 1)
 	//	format = juce::Image::PixelFormat::SingleChannel;
 	juce::Image tmpImage(juce::Image::PixelFormat::RGB, wout, hout, true);
-	juce::Image::BitmapData bitmap(tmpImage, juce::Image::BitmapData::readWrite);
-	for (int i = 0; i < nbBand; ++i) {
-		// Fetch the band
-		GDALRasterBand* band = poDataset->GetRasterBand(i + 1); // Bandes numerotees de 1 à N
-		// Read the data
-		CPLErr error = band->RasterIO(GF_Read, U0, V0, win, hin, &bitmap.data[nbBand - 1 - i], wout, hout, GDT_Byte,
-			bitmap.pixelStride, bitmap.lineStride);
-		if (error == CE_Failure)
-			return false;
+	GDALRasterIOExtraArg psExtraArg;
+	int level = ChooseOverview(source, U0, V0, win, hin, wout, hout, psExtraArg);
+	// Fenetre exacte dans la grille lue
+	double x0 = U0, y0 = V0, w = win, h = hin;
+	if (level >= 0) {
+		x0 = psExtraArg.dfXOff; y0 = psExtraArg.dfYOff;
+		w = psExtraArg.dfXSize; h = psExtraArg.dfYSize;
 	}
-	if (nbBand == 1) {	// Cas des images avec palette de couleurs
-		GDALRasterBand* band = poDataset->GetRasterBand(1);
-		if (band->GetColorInterpretation() == GDALColorInterp::GCI_PaletteIndex) {
-			GDALColorTable* table = band->GetColorTable();
-			const GDALColorEntry* entry;
-			for (int i = 0; i < hout; i++) {
-				juce::uint8* linePix = bitmap.getLinePointer(i);
-				for (int j = 0; j < wout; j++) {
-					entry = table->GetColorEntry(linePix[3 * j]);
-					if (entry == nullptr)
-						continue;
-					linePix[3 * j + 2] = (juce::uint8)entry->c1;	// Ordre BGR dans les images JUCE
-					linePix[3 * j + 1] = (juce::uint8)entry->c2;
-					linePix[3 * j] = (juce::uint8)entry->c3;
-				}
+	// Sous-echantillonnage faible : composition des tuiles decodees en cache. Si une tuile
+	// ne peut pas etre decodee, la fenetre est lue directement
+	bool composed = false;
+	if ((w <= MaxTileFactor * wout) && (h <= MaxTileFactor * hout))
+		composed = ComposeTiles(raster, source, level, x0, y0, w, h, tmpImage);
+	if (!composed) {
+		juce::Image::BitmapData bitmap(tmpImage, juce::Image::BitmapData::readWrite);
+		for (int i = 0; i < nbBand; ++i) {
+			// Fetch the band
+			GDALRasterBand* band = source->GetRasterBand(i + 1); // Bandes numerotees de 1 à N
+			if (level >= 0) {
+				band = band->GetOverview(level);
+				if (band == nullptr)
+					return false;
+				OverviewWindow(band, psExtraArg, U0, V0, win, hin);
 			}
+			// Read the data
+			CPLErr error = band->RasterIO(GF_Read, U0, V0, win, hin, &bitmap.data[nbBand - 1 - i], wout, hout, GDT_Byte,
+				bitmap.pixelStride, bitmap.lineStride, &psExtraArg);
+			if (error == CE_Failure)
+				return false;
 		}
+		if (nbBand == 1)	// Cas des images avec palette de couleurs
+			RasterCache::ApplyPalette(source->GetRasterBand(1), bitmap, wout, hout);
 	}
+	image = tmpImage;
+	return true;
+}
+
+//==============================================================================
+// Melange d'une image lue dans la zone area de l'image raster de la vue
+//==============================================================================
+void MapThread::BlendRaster(const juce::Image& image, int R0, int S0, const juce::Rectangle<int>& area, float opacity)
+{
 	juce::Graphics g(m_Raster);
+	g.reduceClipRegion(area);
 	g.setOpacity(opacity);
-	g.drawImageAt(tmpImage, R0, S0);
+	g.drawImageAt(image, R0, S0);
 	m_nNumObjects++;
-	return true;
 }
 
 //==============================================================================
-// Dessin d'un dataset raster sous forme MNT
+// Dessin d'un dataset raster sous forme MNT : les altitudes sont des flottants,
+// copiees telles quelles dans l'image brute (sans opacite ni juce::Graphics)
 //==============================================================================
-bool MapThread::DrawDtm(GDALDataset* poDataset, float opacity)
+bool MapThread::DrawDtm(GDALDataset* poDataset, const juce::Rectangle<int>& area)
 {
 	int U0, V0, win, hin, R0, S0, wout, hout, nbBand;
-	if (!PrepareRasterDraw(poDataset, U0, V0, win, hin, nbBand, R0, S0, wout, hout))
+	if (!PrepareRasterDraw(poDataset, area, U0, V0, win, hin, nbBand, R0, S0, wout, hout))
 		return false;
 
 	juce::Image tmpImage(m_RawDtm.getFormat(), wout, hout, true);
@@ -543,15 +1141,25 @@ bool MapThread::DrawDtm(GDALDataset* poDataset, float opacity)
 	GDALRasterBand* band = poDataset->GetRasterBand(1); // Bandes numerotees de 1 à N
 	// Lecture des donnees
 	GDALRasterIOExtraArg psExtraArg;
-	INIT_RASTERIO_EXTRA_ARG(psExtraArg);
+	int level = ChooseOverview(poDataset, U0, V0, win, hin, wout, hout, psExtraArg);
+	if (level >= 0) {
+		band = band->GetOverview(level);
+		if (band == nullptr)
+			return false;
+		OverviewWindow(band, psExtraArg, U0, V0, win, hin);
+	}
 	psExtraArg.eResampleAlg = GDALRIOResampleAlg::GRIORA_Bilinear;
 	CPLErr error = band->RasterIO(GF_Read, U0, V0, win, hin, &bitmap.data[0], wout, hout, GDT_Float32,
 			bitmap.pixelStride, bitmap.lineStride, &psExtraArg);
 	if (error == CE_Failure)
 		return false;
-	juce::Graphics g(m_RawDtm);
-	g.setOpacity(1.0);
-	g.drawImageAt(tmpImage, R0, S0);
+	juce::Rectangle<int> copy = juce::Rectangle<int>(R0, S0, wout, hout).getIntersection(area).getIntersection(m_RawDtm.getBounds());
+	if (!copy.isEmpty()) {
+		juce::Image::BitmapData data(m_RawDtm, juce::Image::BitmapData::readWrite);
+		size_t size = (size_t)copy.getWidth() * data.pixelStride;
+		for (int j = copy.getY(); j < copy.getBottom(); j++)
+			memcpy(data.getPixelPointer(copy.getX(), j), bitmap.getPixelPointer(copy.getX() - R0, j - S0), size);
+	}
 	m_nNumObjects++;
 	return true;
 }
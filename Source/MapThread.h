@@ -7,9 +7,12 @@
 
 #pragma once
 
+#include <memory>
 #include <JuceHeader.h>
 #include "ogrsf_frmts.h"
 #include "GeoBase.h"
+#include "VectorRenderer.h"
+#include "TileCache.h"
 
 class GDALDataset;
 
@@ -22,6 +25,18 @@ public:
   void SetBase(GeoBase* base) { m_Base = base; }
   void SetUpdate(bool overlay, bool raster, bool dtm, bool vector);
   bool NeedUpdate() { return m_bRaster; }
+  void SetParallel(bool parallel) { m_bParallel = parallel; }
+  bool Parallel() { return m_bParallel; }
+  void SetBatch(bool batch) { m_bBatch = batch; m_Renderer.SetBatch(batch); }
+  bool Batch() { return m_bBatch; }
+  void SetProgressive(bool progressive) { m_bProgressive = progressive; }
+  bool Progressive() { return m_bProgressive; }
+  void SetTiles(bool tiles) { m_bTiles = tiles; }
+  bool Tiles() { return m_bTiles; }
+  void SetTileDiskCache(const juce::File& folder) { m_Tiles.SetDiskCache(folder); }
+  juce::File TileDiskCache() { return m_Tiles.DiskCache(); }
+  void InvalidateTiles(int layerId) { m_Tiles.InvalidateLayer(layerId); }
+  void ClearTiles() { m_Tiles.Clear(); }
 
   juce::int64 NumObjects() { return m_nNumObjects; }
   OGREnvelope Envelope() { return m_Env; }
@@ -33,7 +48,9 @@ public:
 
 private:
   juce::Image m_Raster;
-  juce::Image m_Vector;
+  juce::Image m_Vector;         // Image de travail, propre au thread de dessin
+  std::shared_ptr<juce::Image> m_VectorFront; // Derniere image publiee pour MapView::paint
+  juce::uint32  m_nLastPublish; // Date de la derniere publication (ms)
   juce::Image m_Overlay;
   juce::Image m_Dtm;
   juce::Image m_RawDtm;
@@ -41,34 +58,40 @@ private:
   double        m_dX0, m_dY0, m_dScale; // Transformation terrain -> pixel
   bool          m_bRaster, m_bVector, m_bOverlay, m_bDtm; // Couches a dessiner
   bool          m_bRasterDone;
-  double*       m_Pt;
-  int           m_nPtAlloc;
-  juce::Path    m_Path;
-  bool          m_bFill;        // Indique que le path doit etre rempli
+  bool          m_bRasterValid, m_bDtmValid;  // Images raster et MNT completes pour la vue courante
+  juce::RectangleList<int> m_RasterRegion;  // Zones de la vue a lire pour les rasters
+  juce::RectangleList<int> m_DtmRegion;     // Zones de la vue a lire pour les MNT
+  bool          m_bParallel;    // Dessin des layers vectoriels en parallele
+  bool          m_bBatch;       // Dessin des features par lots de meme style
+  bool          m_bProgressive; // Dessin progressif : gros objets d'abord, du centre vers les bords
+  bool          m_bTiles;       // Composition de la vue a partir des tuiles en cache
+  TileCache     m_Tiles;        // Tuiles deja dessinees des layers vectoriels
+  VectorRenderer  m_Renderer;
+  std::unique_ptr<juce::ThreadPool> m_Pool; // Threads de dessin des layers vectoriels
   juce::int64   m_nNumObjects;  // Nombre d'objets affiches dans la vue
   OGREnvelope   m_Env;
   OGRSpatialReference m_SpatialRef;
   juce::Rectangle<int>  m_ClipVector;
 
-  bool AllocPoints(int numPt);
   void SetDimension(const int& w, const int& h);
   void PrepareImages(bool totalUpdate, int dX = 0, int dY = 0);
+  void PublishVector(bool force, juce::uint32 delay = 100);
 
   void DrawLayer(GeoBase::VectorLayer* layer);
-  void DrawGeometry(const OGRGeometry*);
-  void DrawPoint(const OGRGeometry*);
-  void DrawPolygon(const OGRGeometry*);
-  void DrawMultiPolygon(const OGRGeometry*);
-  void DrawLineString(const OGRGeometry*);
-  void DrawMultiLineString(const OGRGeometry*);
-  void DrawMultiPoint(const OGRGeometry*);
-  void DrawCurve(const OGRCurve*);
-  void DrawLinearRing(const OGRLinearRing*);
+  void DrawVectorLayers(const std::vector<GeoBase::VectorLayer*>& layers);
+  void DrawVectorProgressive(const std::vector<GeoBase::VectorLayer*>& layers);
+  void DrawVectorTiles(const std::vector<GeoBase::VectorLayer*>& layers);
+  juce::Image DrawTile(GeoBase::VectorLayer* layer, GeoBase::Transformation* transfo, int tx, int ty);
 
+  friend class RasterReadJob;
+  OGREnvelope PixelEnvelope(const juce::Rectangle<int>& area);
   bool DrawLayer(GeoBase::RasterLayer* layer, bool dtm = false);
-  bool DrawRaster(GDALDataset* poDataset, float opacity = 1.f);
-  bool DrawDtm(GDALDataset* poDataset, float opacity = 1.f);
-  bool PrepareRasterDraw(GDALDataset* poDataset, int& U0, int& V0, int& win, int& hin, int& nbBand, 
+  bool DrawRasters(GeoBase::RasterLayer* layer, const std::vector<std::pair<int, juce::Rectangle<int> > >& reads);
+  bool DrawRaster(GDALDataset* poDataset, const void* raster, const juce::Rectangle<int>& area, float opacity = 1.f);
+  bool ReadRaster(const void* raster, GDALDataset* source, const juce::Rectangle<int>& area, juce::Image& image, int& R0, int& S0);
+  void BlendRaster(const juce::Image& image, int R0, int S0, const juce::Rectangle<int>& area, float opacity);
+  bool DrawDtm(GDALDataset* poDataset, const juce::Rectangle<int>& area);
+  bool PrepareRasterDraw(GDALDataset* poDataset, const juce::Rectangle<int>& area, int& U0, int& V0, int& win, int& hin, int& nbBand, 
                                                  int& R0, int& S0, int& wout, int& hout);
 
   void DrawSelection();
@@ -15,6 +15,7 @@ MapView::MapView() : m_MapThread("MapThread")
 {
 	m_dX0 = m_dY0 = m_dX = m_dY = m_dZ = 0.;
 	m_dScale = 1.0;
+	m_dPickTolerance = 5.;
 	m_bDrag = m_bZoom = m_bSelect = false;
 	m_Base = nullptr;
 	setOpaque(true);
@@ -109,6 +110,19 @@ void MapView::RenderMap(bool overlay, bool raster, bool dtm,  bool vector, bool
 	m_MapThread.startThread();
 }
 
+//==============================================================================
+// Ecriture sur disque des tuiles retirees du cache memoire
+//==============================================================================
+void MapView::SetTileDiskCache(bool disk)
+{
+	m_MapThread.stopThread(-1);
+	if (disk)
+		m_MapThread.SetTileDiskCache(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("GdalMapTiles"));
+	else
+		m_MapThread.SetTileDiskCache(juce::File());
+	RenderMap(true, false, false, true, false);
+}
+
 //==============================================================================
 // Gestion de la souris
 //==============================================================================
@@ -327,20 +341,17 @@ void MapView::SetFrame(OGREnvelope env)
 }
 
 //==============================================================================
-// Selection des vecteurs se trouvant proche du point P (coordoonees pixel)
+// Selection des vecteurs les plus proches du point P (coordoonees pixel)
 //==============================================================================
 void MapView::SelectFeatures(juce::Point<int> P)
 {
 	if (m_Base == nullptr)
 		return;
-	OGREnvelope env;
-	double X = P.x - 1, Y = P.y - 1;
+	double X = P.x, Y = P.y;
 	Pixel2Ground(X, Y);
-	env.Merge(X, Y);
-	X = P.x + 1; Y = P.y + 1;
-	Pixel2Ground(X, Y);
-	env.Merge(X, Y);
-	m_Base->SelectFeatures(env, m_MapThread.SpatialRef());
+	if (m_Base->SharedSelection())	// La selection modifierait la lecture en cours du dessin
+		m_MapThread.stopThread(-1);
+	m_Base->SelectNearestFeatures(X, Y, m_dPickTolerance * m_dScale, m_MapThread.SpatialRef());
 	sendActionMessage("UpdateSelectFeatures");
 }
 
@@ -352,6 +363,8 @@ void MapView::SelectFeatures(const double& X0, const double& Y0, const double& X
 	OGREnvelope env;
 	env.Merge(X0, Y0);
 	env.Merge(X1, Y1);
+	if (m_Base->SharedSelection())	// La selection modifierait la lecture en cours du dessin
+		m_MapThread.stopThread(-1);
 	m_Base->SelectFeatures(env, m_MapThread.SpatialRef());
 	sendActionMessage("UpdateSelectFeatures");
 }
@@ -32,8 +32,20 @@ public:
   void CenterView(const double& X, const double& Y);
   void Pixel2Ground(double& X, double& Y);
   void Ground2Pixel(double& X, double& Y);
-  void SetBase(GeoBase* base) { m_MapThread.stopThread(-1); m_Base = base; resized(); }
+  void SetBase(GeoBase* base) { m_MapThread.stopThread(-1); m_Base = base; m_MapThread.ClearTiles(); resized(); }
+  void StopRendering() { m_MapThread.stopThread(-1); }
   void StopThread() { m_MapThread.stopThread(-1); m_Image.clear(m_Image.getBounds()); RenderMap(); }
+  void SetParallel(bool parallel) { m_MapThread.stopThread(-1); m_MapThread.SetParallel(parallel); RenderMap(true, false, false, true, true); }
+  bool Parallel() { return m_MapThread.Parallel(); }
+  void SetProgressive(bool progressive) { m_MapThread.stopThread(-1); m_MapThread.SetProgressive(progressive); RenderMap(true, false, false, true, true); }
+  bool Progressive() { return m_MapThread.Progressive(); }
+  void SetBatch(bool batch) { m_MapThread.stopThread(-1); m_MapThread.SetBatch(batch); RenderMap(true, false, false, true, true); }
+  bool Batch() { return m_MapThread.Batch(); }
+  void SetTiles(bool tiles) { m_MapThread.stopThread(-1); m_MapThread.SetTiles(tiles); RenderMap(true, true, true, true, true); }
+  bool Tiles() { return m_MapThread.Tiles(); }
+  void SetTileDiskCache(bool disk);
+  bool TileDiskCache() { return m_MapThread.TileDiskCache() != juce::File(); }
+  void InvalidateLayer(int layerId) { m_MapThread.InvalidateTiles(layerId); }
   void RenderMap(bool overlay = true, bool raster = true, bool dtm = true, bool vector = true, bool force_vector = false);
   void SelectFeatures(juce::Point<int>);
   void SelectFeatures(const double& X0, const double& Y0, const double& X1, const double& Y1);
@@ -54,6 +66,7 @@ private:
   double				m_dX0;
   double				m_dY0;
   double        m_dScale;
+  double        m_dPickTolerance; // Tolerance de selection par clic (pixels)
   bool					m_bDrag;
   bool          m_bZoom;
   bool          m_bSelect;
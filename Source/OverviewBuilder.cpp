@@ -0,0 +1,216 @@
+//==============================================================================
+// OverviewBuilder.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "OverviewBuilder.h"
+
+OverviewBuilder::OverviewBuilder() : juce::Thread("OverviewBuilder")
+{
+	m_Current = nullptr;
+	m_dProgress = 0.;
+	m_nJobDone = m_nJobCount = 0;
+	m_bRunning = false;
+}
+
+OverviewBuilder::~OverviewBuilder()
+{
+	Cancel();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (size_t i = 0; i < m_Done.size(); i++)
+		if (m_Done[i].NewDataset != nullptr)
+			m_Done[i].NewDataset->Release();
+	m_Done.clear();
+}
+
+//==============================================================================
+// Ajout des datasets d'un layer a la file de calcul. Les rasters ouverts a la
+// demande (repertoire d'images) sont traites par leur fichier
+// Renvoie false si aucun raster ne peut etre traite
+//==============================================================================
+bool OverviewBuilder::Build(GeoBase::RasterLayer* layer)
+{
+	if ((layer == nullptr) || (IsBuilding(layer)))
+		return false;
+	size_t nbJob = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (int i = 0; i < layer->GetRasterCount(); i++) {
+			GeoBase::Raster* raster = layer->GetRaster(i);
+			GDALDataset* poDataset = raster->Dataset();
+			std::string filename = (poDataset != nullptr) ? poDataset->GetDescription() : raster->File();
+			if (filename.empty())
+				continue;
+			m_Queue.push_back({ layer, poDataset, filename, nullptr, 0 });
+			nbJob++;
+		}
+	}
+	if (nbJob < 1)
+		return false;
+	bool start = false;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		start = !m_bRunning;
+		m_bRunning = true;
+	}
+	if (start) {
+		waitForThreadToExit(-1);  // Le thread a pu trouver la file vide sans etre encore sorti
+		startThread();
+	}
+	return true;
+}
+
+//==============================================================================
+// Arret du calcul : les datasets en file sont abandonnes
+//==============================================================================
+void OverviewBuilder::Cancel()
+{
+	signalThreadShouldExit();
+	stopThread(-1);
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Queue.clear();
+	m_Current = nullptr;
+	m_bRunning = false;
+}
+
+bool OverviewBuilder::IsBuilding(GeoBase::RasterLayer* layer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Current == layer)
+		return true;
+	for (size_t i = 0; i < m_Queue.size(); i++)
+		if (m_Queue[i].Layer == layer)
+			return true;
+	return false;
+}
+
+//==============================================================================
+// Progression du calcul d'un layer (entre 0 et 1)
+//==============================================================================
+double OverviewBuilder::Progress(GeoBase::RasterLayer* layer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Current == layer) {
+		if (m_nJobCount < 1)
+			return 0.;
+		return (m_nJobDone + m_dProgress) / m_nJobCount;
+	}
+	for (size_t i = 0; i < m_Queue.size(); i++)
+		if (m_Queue[i].Layer == layer)
+			return 0.;
+	return -1.;
+}
+
+//==============================================================================
+// Remplacement dans la base des datasets rouverts avec leurs apercus
+// Le thread de dessin doit etre arrete
+//==============================================================================
+bool OverviewBuilder::Commit(GeoBase* base)
+{
+	std::vector<Job> done;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		done.swap(m_Done);
+	}
+	bool flag = false;
+	for (size_t i = 0; i < done.size(); i++) {
+		if (done[i].Dataset != nullptr)
+			flag |= base->ReplaceDataset(done[i].Dataset, done[i].NewDataset);
+		else
+			flag |= base->UpdateOverviews(done[i].Filename, done[i].Overviews);
+	}
+	return flag;
+}
+
+//==============================================================================
+// Calcul des apercus, dataset par dataset
+//==============================================================================
+void OverviewBuilder::run()
+{
+	while (true) {
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Queue.size() < 1) {
+				m_Current = nullptr;
+				m_bRunning = false;
+				return;
+			}
+			job = m_Queue.front();
+			m_Queue.erase(m_Queue.begin());
+			if (m_Current != job.Layer) {
+				m_Current = job.Layer;
+				m_nJobDone = 0;
+				m_nJobCount = 1;
+				for (size_t i = 0; i < m_Queue.size(); i++)
+					if (m_Queue[i].Layer == job.Layer)
+						m_nJobCount++;
+			}
+			m_dProgress = 0.;
+		}
+		// Handle propre au thread : le dataset de la base est utilise par le dessin
+		GDALDataset* poDataset = GDALDataset::Open(job.Filename.c_str(), GDAL_OF_RASTER | GDAL_OF_READONLY);
+		bool built = false;
+		if (poDataset != nullptr) {
+			built = BuildOverviews(poDataset);
+			if (built)
+				job.Overviews = poDataset->GetRasterBand(1)->GetOverviewCount();
+			poDataset->Release();
+		}
+		if (built && (!threadShouldExit())) {
+			DatasetPool::Instance().Close(job.Filename); // Les handles du pool ne connaissent pas les apercus
+			if (job.Dataset != nullptr)	// Un raster ouvert a la demande est relu par le pool
+				job.NewDataset = GDALDataset::Open(job.Filename.c_str(), GDAL_OF_RASTER | GDAL_OF_READONLY);
+			if ((job.Dataset == nullptr) || (job.NewDataset != nullptr)) {
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_Done.push_back(job);
+				}
+				sendActionMessage("OverviewsBuilt");
+			}
+		}
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_nJobDone++;
+		m_dProgress = 0.;
+		if (threadShouldExit()) {
+			m_Queue.clear();
+			m_Current = nullptr;
+			m_bRunning = false;
+			return;
+		}
+	}
+}
+
+//==============================================================================
+// Calcul des apercus d'un dataset : facteurs 2, 4, 8 ... jusqu'a une taille de
+// 256 pixels. Renvoie false si le dataset a deja des apercus ou si le calcul echoue
+//==============================================================================
+bool OverviewBuilder::BuildOverviews(GDALDataset* poDataset)
+{
+	const int minSize = 256;
+	if ((poDataset->GetRasterCount() < 1) || (poDataset->GetRasterBand(1)->GetOverviewCount() > 0))
+		return false;
+	std::vector<int> levels;
+	int size = std::max(poDataset->GetRasterXSize(), poDataset->GetRasterYSize());
+	for (int factor = 2; size / factor >= minSize; factor *= 2)
+		levels.push_back(factor);
+	if (levels.size() < 1)
+		return false;
+	CPLErr error = GDALBuildOverviews((GDALDatasetH)poDataset, "AVERAGE", (int)levels.size(), levels.data(), 0, nullptr, ProgressCallback, this);
+	return (error == CE_None);
+}
+
+//==============================================================================
+// Progression GDAL : renvoie FALSE pour interrompre le calcul
+//==============================================================================
+int CPL_STDCALL OverviewBuilder::ProgressCallback(double complete, const char*, void* data)
+{
+	OverviewBuilder* builder = (OverviewBuilder*)data;
+	{
+		std::lock_guard<std::mutex> lock(builder->m_Mutex);
+		builder->m_dProgress = complete;
+	}
+	return builder->threadShouldExit() ? FALSE : TRUE;
+}
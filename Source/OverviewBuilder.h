@@ -0,0 +1,57 @@
+//==============================================================================
+// OverviewBuilder.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <JuceHeader.h>
+#include "GeoBase.h"
+
+//==============================================================================
+// OverviewBuilder : calcul des apercus (.ovr) des rasters qui n'en ont pas,
+// dans un thread. Chaque dataset est lu par son propre handle ; quand ses apercus
+// sont ecrits, il est rouvert et le message "OverviewsBuilt" est envoye. Le
+// nouveau dataset remplace l'ancien dans la base par Commit, depuis le thread
+// des messages, le thread de dessin etant arrete. Un raster ouvert a la demande
+// n'a pas de dataset : seul son nombre d'apercus est mis a jour par Commit
+//==============================================================================
+class OverviewBuilder : public juce::Thread, public juce::ActionBroadcaster {
+public:
+  OverviewBuilder();
+  ~OverviewBuilder() override;
+
+  bool Build(GeoBase::RasterLayer* layer);
+  bool Commit(GeoBase* base);
+  void Cancel();
+  bool IsBuilding(GeoBase::RasterLayer* layer);
+  bool IsRunning() { std::lock_guard<std::mutex> lock(m_Mutex); return m_bRunning; }
+  double Progress(GeoBase::RasterLayer* layer);  // -1 si le layer n'est pas en cours de calcul
+
+  void run() override;
+
+private:
+  typedef struct {
+    GeoBase::RasterLayer* Layer;
+    GDALDataset*          Dataset;    // Dataset de la base (nullptr : raster ouvert a la demande)
+    std::string           Filename;
+    GDALDataset*          NewDataset; // Dataset rouvert avec ses apercus
+    int                   Overviews;  // Nombre d'apercus calcules
+  } Job;
+
+  std::mutex              m_Mutex;    // Acces aux listes et a la progression
+  std::vector<Job>        m_Queue;    // Datasets a traiter
+  std::vector<Job>        m_Done;     // Datasets rouverts, en attente de Commit
+  GeoBase::RasterLayer*   m_Current;  // Layer en cours de calcul
+  double                  m_dProgress;
+  size_t                  m_nJobDone; // Nombre de datasets traites pour m_Current
+  size_t                  m_nJobCount;
+  bool                    m_bRunning; // Le thread traite la file
+
+  bool BuildOverviews(GDALDataset* poDataset);
+  static int CPL_STDCALL ProgressCallback(double complete, const char* message, void* data);
+};
@@ -0,0 +1,162 @@
+//==============================================================================
+// RasterCache.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include <algorithm>
+#include "RasterCache.h"
+
+//==============================================================================
+// Cache partage par toutes les vues
+//==============================================================================
+RasterCache& RasterCache::Instance()
+{
+	static RasterCache cache;
+	return cache;
+}
+
+void RasterCache::SetBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_nBudget = budget;
+	Evict();
+}
+
+//==============================================================================
+// Recherche d'une tuile
+//==============================================================================
+juce::Image RasterCache::Find(const Key& key)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto iter = m_Map.find(key);
+	if (iter == m_Map.end())
+		return juce::Image();
+	m_List.splice(m_List.begin(), m_List, iter->second);
+	return iter->second->second;
+}
+
+//==============================================================================
+// Ajout d'une tuile
+//==============================================================================
+void RasterCache::Insert(const Key& key, const juce::Image& tile)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto iter = m_Map.find(key);
+	if (iter != m_Map.end()) {
+		m_nSize -= ImageSize(iter->second->second);
+		m_List.erase(iter->second);
+		m_Map.erase(iter);
+	}
+	m_List.emplace_front(key, tile);
+	m_Map[key] = m_List.begin();
+	m_nSize += ImageSize(tile);
+	Evict();
+}
+
+//==============================================================================
+// Retrait des tuiles les plus anciennes
+//==============================================================================
+void RasterCache::Evict()
+{
+	while ((m_nSize > m_nBudget) && (m_List.size() > 0)) {
+		auto last = std::prev(m_List.end());
+		m_nSize -= ImageSize(last->second);
+		m_Map.erase(last->first);
+		m_List.pop_back();
+	}
+}
+
+//==============================================================================
+// Retrait des tuiles d'un raster (dataset remplace)
+//==============================================================================
+void RasterCache::Invalidate(const void* raster)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto iter = m_List.begin(); iter != m_List.end(); ) {
+		if (iter->first.Raster != raster) {
+			++iter;
+			continue;
+		}
+		m_nSize -= ImageSize(iter->second);
+		m_Map.erase(iter->first);
+		iter = m_List.erase(iter);
+	}
+}
+
+void RasterCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_List.clear();
+	m_Map.clear();
+	m_nSize = 0;
+}
+
+//==============================================================================
+// Tuile decodee : la lecture GDAL se fait hors du verrou du cache
+//==============================================================================
+juce::Image RasterCache::Tile(const void* raster, GDALDataset* poDataset, int level, int tx, int ty)
+{
+	Key key = { raster, level, tx, ty };
+	juce::Image tile = Find(key);
+	if (tile.isValid())
+		return tile;
+
+	int nbBand = poDataset->GetRasterCount();
+	if (nbBand > 3) nbBand = 3;
+	GDALRasterBand* ref = poDataset->GetRasterBand(1);
+	if (ref == nullptr)
+		return juce::Image();
+	if (level >= 0)
+		ref = ref->GetOverview(level);
+	if (ref == nullptr)
+		return juce::Image();
+	int U0 = tx * TileSize, V0 = ty * TileSize;
+	int w = std::min(TileSize, ref->GetXSize() - U0);
+	int h = std::min(TileSize, ref->GetYSize() - V0);
+	if ((U0 < 0) || (V0 < 0) || (w < 1) || (h < 1))
+		return juce::Image();
+
+	tile = juce::Image(juce::Image::PixelFormat::RGB, w, h, true);
+	juce::Image::BitmapData bitmap(tile, juce::Image::BitmapData::readWrite);
+	for (int i = 0; i < nbBand; ++i) {
+		GDALRasterBand* band = poDataset->GetRasterBand(i + 1);
+		if ((band != nullptr) && (level >= 0))
+			band = band->GetOverview(level);
+		if (band == nullptr)
+			return juce::Image();
+		CPLErr error = band->RasterIO(GF_Read, U0, V0, w, h, &bitmap.data[nbBand - 1 - i], w, h, GDT_Byte,
+			bitmap.pixelStride, bitmap.lineStride, nullptr);
+		if (error == CE_Failure)
+			return juce::Image();
+	}
+	if (nbBand == 1)
+		ApplyPalette(poDataset->GetRasterBand(1), bitmap, w, h);
+	Insert(key, tile);
+	return tile;
+}
+
+//==============================================================================
+// Conversion des index d'une image a palette en couleurs (ordre BGR des images JUCE)
+//==============================================================================
+void RasterCache::ApplyPalette(GDALRasterBand* band, juce::Image::BitmapData& bitmap, int w, int h)
+{
+	if ((band == nullptr) || (band->GetColorInterpretation() != GDALColorInterp::GCI_PaletteIndex))
+		return;
+	GDALColorTable* table = band->GetColorTable();
+	if (table == nullptr)
+		return;
+	const GDALColorEntry* entry;
+	for (int i = 0; i < h; i++) {
+		juce::uint8* linePix = bitmap.getLinePointer(i);
+		for (int j = 0; j < w; j++) {
+			entry = table->GetColorEntry(linePix[3 * j]);
+			if (entry == nullptr)
+				continue;
+			linePix[3 * j + 2] = (juce::uint8)entry->c1;
+			linePix[3 * j + 1] = (juce::uint8)entry->c2;
+			linePix[3 * j] = (juce::uint8)entry->c3;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+//==============================================================================
+// RasterCache.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <JuceHeader.h>
+#include "gdal_priv.h"
+
+//==============================================================================
+// RasterCache : cache des tuiles raster deja decodees, pretes a l'affichage (BGR)
+// Une tuile est identifiee par (raster, apercu, colonne, ligne) : les tuiles
+// decoupent la grille de l'apercu (ou de la pleine resolution) en carres de
+// TileSize pixels. Les tuiles les moins recentes sont retirees au-dela du budget
+//==============================================================================
+class RasterCache {
+public:
+	static const int TileSize = 256;
+
+	typedef struct Key {
+		const void*					Raster;	// Identifiant du raster (GeoBase::Raster), independant du handle lu
+		int									Level;	// Apercu (-1 : pleine resolution)
+		int									X, Y;		// Colonne et ligne de la tuile
+		bool operator==(const Key& k) const { return (Raster == k.Raster) && (Level == k.Level) && (X == k.X) && (Y == k.Y); }
+	} Key;
+
+	RasterCache(size_t budget = 128 * 1024 * 1024) { m_nBudget = budget; m_nSize = 0; }
+	static RasterCache& Instance();
+
+	void SetBudget(size_t budget);
+	size_t Budget() { std::lock_guard<std::mutex> lock(m_Mutex); return m_nBudget; }
+	size_t Size() { std::lock_guard<std::mutex> lock(m_Mutex); return m_nSize; }
+
+	juce::Image Find(const Key& key);
+	void Insert(const Key& key, const juce::Image& tile);
+	void Invalidate(const void* raster);
+	void Clear();
+
+	// Tuile decodee : dans le cache, sinon lue dans poDataset, un handle du raster, puis ajoutee au cache
+	juce::Image Tile(const void* raster, GDALDataset* poDataset, int level, int tx, int ty);
+	// Conversion des index d'une image a palette en couleurs
+	static void ApplyPalette(GDALRasterBand* band, juce::Image::BitmapData& bitmap, int w, int h);
+
+private:
+	struct KeyHash {
+		size_t operator()(const Key& k) const {
+			juce::uint64 h = (juce::uint64)(juce::pointer_sized_uint)k.Raster * 0x9E3779B97F4A7C15ULL;
+			h ^= ((juce::uint64)(juce::uint32)k.X << 32) ^ (juce::uint32)k.Y;
+			h ^= (juce::uint64)(k.Level + 1) << 24;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+	typedef std::list<std::pair<Key, juce::Image> > List;
+	List															m_List;		// De la plus recente a la plus ancienne
+	std::unordered_map<Key, List::iterator, KeyHash>	m_Map;
+	size_t														m_nSize;
+	size_t														m_nBudget;
+	std::mutex												m_Mutex;
+
+	void Evict();
+	static size_t ImageSize(const juce::Image& image) { return (size_t)image.getWidth() * image.getHeight() * 3; }
+};
@@ -14,6 +14,7 @@
 RasterLayerViewerModel::RasterLayerViewerModel()
 {
 	m_Base = nullptr;
+	m_Builder = nullptr;
 	m_ActiveRow = m_ActiveColumn = -1;
 }
 
@@ -64,6 +65,21 @@ void RasterLayerViewerModel::paintCell(juce::Graphics& g, int rowNumber, int col
 	case Column::GSD:
 		g.drawText(juce::String(geoLayer->GSD()), 0, 0, width, height, juce::Justification::centredLeft);
 		break;
+	case Column::Overviews:
+		{
+			double progress = (m_Builder != nullptr) ? m_Builder->Progress(geoLayer) : -1.;
+			if (progress >= 0.) {
+				g.setColour(juce::Colours::teal);
+				g.fillRect(0, 1, (int)(width * progress), height - 2);
+				g.setColour(juce::Colours::white);
+				g.drawText(juce::String((int)(progress * 100.)) + " %", 0, 0, width, height, juce::Justification::centred);
+			}
+			else if (geoLayer->Overviews() > 0)
+				g.drawText(juce::String(geoLayer->Overviews()), 0, 0, width, height, juce::Justification::centred);
+			else
+				g.drawText(juce::translate("Build"), 0, 0, width, height, juce::Justification::centred);
+		}
+		break;
 	}
 }
 
@@ -90,6 +106,13 @@ void RasterLayerViewerModel::cellClicked(int rowNumber, int columnId, const juce
 		return;
 	}
 
+	// Calcul des apercus des datasets qui n'en ont pas
+	if ((columnId == Column::Overviews) && (m_Builder != nullptr)) {
+		if ((layer->Overviews() < 1) && (m_Builder->Build(layer)))
+			sendActionMessage("BuildOverviews");
+		return;
+	}
+
 	// Choix d'une opacite
 	if (columnId == Column::Opacity) {
 		auto opacitySelector = std::make_unique<juce::Slider>();
@@ -175,6 +198,7 @@ RasterLayerViewer::RasterLayerViewer()
 	m_Table.getHeader().addColumn(juce::translate("Name"), RasterLayerViewerModel::Column::Name, 200);
 	m_Table.getHeader().addColumn(juce::translate("Opacity"), RasterLayerViewerModel::Column::Opacity, 50);
 	m_Table.getHeader().addColumn(juce::translate("GSD"), RasterLayerViewerModel::Column::GSD, 50);
+	m_Table.getHeader().addColumn(juce::translate("Overviews"), RasterLayerViewerModel::Column::Overviews, 60);
 	m_Table.setSize(352, 200);
 	m_Table.setModel(&m_Model);
 	addAndMakeVisible(m_Table);
@@ -189,6 +213,7 @@ void RasterLayerViewer::UpdateColumnName()
 	m_Table.getHeader().setColumnName(RasterLayerViewerModel::Column::Name, juce::translate("Name"));
 	m_Table.getHeader().setColumnName(RasterLayerViewerModel::Column::Opacity, juce::translate("Opacity"));
 	m_Table.getHeader().setColumnName(RasterLayerViewerModel::Column::GSD, juce::translate("GSD"));
+	m_Table.getHeader().setColumnName(RasterLayerViewerModel::Column::Overviews, juce::translate("Overviews"));
 }
 
 //==============================================================================
@@ -199,6 +224,18 @@ void RasterLayerViewer::actionListenerCallback(const juce::String& message)
 	if (message == "UpdateRaster") {
 		repaint();
 	}
+	if (message == "BuildOverviews")
+		startTimer(250);
+}
+
+//==============================================================================
+// Rafraichissement de la progression tant que des apercus sont calcules
+//==============================================================================
+void RasterLayerViewer::timerCallback()
+{
+	m_Table.repaint();
+	if ((m_Model.Builder() == nullptr) || (!m_Model.Builder()->IsRunning()))
+		stopTimer();
 }
 
 //==============================================================================
@@ -8,6 +8,7 @@
 #pragma once
 #include <JuceHeader.h>
 #include "GeoBase.h"
+#include "OverviewBuilder.h"
 
 //==============================================================================
 // RasterLayerViewerModel : table pour montrer les proprietes des layers
@@ -17,7 +18,7 @@ class RasterLayerViewerModel : public juce::TableListBoxModel,
 	public juce::Slider::Listener,
 	public juce::ActionBroadcaster {
 public:
-	typedef enum { Visibility = 1, Name = 2, Opacity = 3, GSD = 4 } Column;
+	typedef enum { Visibility = 1, Name = 2, Opacity = 3, GSD = 4, Overviews = 5 } Column;
 	RasterLayerViewerModel();
 
 	int getNumRows() override;
@@ -30,9 +31,12 @@ public:
 	void sliderValueChanged(juce::Slider* slider) override;
 
 	void SetBase(GeoBase* base) { m_Base = base; }
+	void SetBuilder(OverviewBuilder* builder) { m_Builder = builder; }
+	OverviewBuilder* Builder() { return m_Builder; }
 
 private:
 	GeoBase* m_Base;
+	OverviewBuilder*			m_Builder;	// Calcul des apercus
 	int										m_ActiveRow;
 	int										m_ActiveColumn;
 };
@@ -43,11 +47,14 @@ private:
 class RasterLayerViewer : public juce::Component,
 	public juce::ActionListener,
 	public juce::DragAndDropTarget,
-	public juce::DragAndDropContainer {
+	public juce::DragAndDropContainer,
+	private juce::Timer {
 public:
 	RasterLayerViewer();
+	~RasterLayerViewer() override { stopTimer(); }
 
 	void SetBase(GeoBase* base) { m_Base = base;  m_Model.SetBase(base); m_Table.updateContent(); }
+	void SetBuilder(OverviewBuilder* builder) { m_Model.SetBuilder(builder); }
 	void SetActionListener(juce::ActionListener* listener) { m_Model.addActionListener(listener); }
 	void UpdateColumnName();
 	void resized() override { auto b = getLocalBounds(); m_Table.setSize(b.getWidth(), b.getHeight()); }
@@ -66,5 +73,7 @@ private:
 	juce::TableListBox				m_Table;
 	RasterLayerViewerModel		m_Model;
 
+	void timerCallback() override;	// Progression du calcul des apercus
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RasterLayerViewer)
 };
\ No newline at end of file
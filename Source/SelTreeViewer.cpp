@@ -24,9 +24,9 @@ void SelTreeItem::itemOpennessChanged(bool isNowOpen)
       return;
     }
     else {  // Feature
-      m_Base->SelectFeatureFields(m_Feature.IdLayer(), m_Feature.Id());
-      for (int i = 0; i < m_Base->GetFieldCount(); i++) {
-        SelTreeItem* item = new SelTreeItem(m_Base->GetFieldName(i), m_Base->GetFieldValue(i));
+      int nbField = m_Base->GetFieldCount(m_Feature.IdLayer());
+      for (int i = 0; i < nbField; i++) {
+        SelTreeItem* item = new SelTreeItem(m_Base, m_Feature, i);
         addSubItem(item);
       }
       return;
@@ -42,7 +42,7 @@ void SelTreeItem::itemOpennessChanged(bool isNowOpen)
 void SelTreeItem::paintItem(juce::Graphics& g, int width, int height)
 {
   g.setFont(15.0f);
-  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr)) {
+  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr) && (m_nField < 0)) {
     OGRLayer* ogrLayer = m_Base->GetOGRLayer(m_Feature.IdLayer());
     if (ogrLayer == nullptr)
       return;
@@ -51,10 +51,12 @@ void SelTreeItem::paintItem(juce::Graphics& g, int width, int height)
     g.drawText(juce::String(ogrLayer->GetName()), 4, 0, width - 4, height, juce::Justification::centredLeft, true);
     return;
   }
-  juce::String text = m_AttName;
+  if ((m_Base == nullptr) || (m_nField < 0))
+    return;
+  juce::String text = juce::String(m_Base->GetFieldName(m_Feature.IdLayer(), m_nField));
   g.setColour(juce::Colours::coral);
   g.drawText(text, 4, 0, width / 4 - 4, height, juce::Justification::centredLeft, true);
-  text = m_AttValue;
+  text = juce::String::fromUTF8(m_Base->GetFieldValue(m_Feature.IdLayer(), m_Feature.Id(), m_nField).c_str());
   g.setColour(juce::Colours::lightyellow);
   g.drawText(text, 4 + width / 4, 0, 3 * width / 4 - 4, height, juce::Justification::centredLeft, true);
 }
@@ -64,7 +66,7 @@ void SelTreeItem::paintItem(juce::Graphics& g, int width, int height)
 //==============================================================================
 void SelTreeItem::itemClicked(const juce::MouseEvent&)
 {
-  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr)) {
+  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr) && (m_nField < 0)) {
     SelTreeViewer* viewer = static_cast<SelTreeViewer*>(getOwnerView());
     viewer->sendActionMessage("SelectFeature:" + juce::String(m_Feature.Id()) + ":" + juce::String(m_Feature.IdLayer()));
   }
@@ -75,7 +77,7 @@ void SelTreeItem::itemClicked(const juce::MouseEvent&)
 //==============================================================================
 void SelTreeItem::itemDoubleClicked(const juce::MouseEvent&)
 {
-  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr)) {
+  if ((m_Feature.IdLayer() >= 0) && (m_Base != nullptr) && (m_nField < 0)) {
     SelTreeViewer* viewer = static_cast<SelTreeViewer*>(getOwnerView());
     OGREnvelope env = m_Feature.Envelope();
     OGRLayer* layer = m_Base->GetOGRLayer(m_Feature.IdLayer());
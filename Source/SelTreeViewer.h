@@ -12,13 +12,14 @@
 
 class SelTreeItem : public juce::TreeViewItem {
 public:
-  SelTreeItem() { m_Base = nullptr; }
-  SelTreeItem(GeoBase* base, GeoBase::Feature feature) { m_Base = base; m_Feature = feature; }
-  SelTreeItem(std::string name, std::string value) { m_Base = nullptr; m_AttName = name; m_AttValue = value; }
+  SelTreeItem() { m_Base = nullptr; m_nField = -1; }
+  SelTreeItem(GeoBase* base, GeoBase::Feature feature) { m_Base = base; m_Feature = feature; m_nField = -1; }
+  // Champ d'un feature : la valeur n'est lue qu'au premier affichage
+  SelTreeItem(GeoBase* base, GeoBase::Feature feature, int field) { m_Base = base; m_Feature = feature; m_nField = field; }
 
   void SetBase(GeoBase* base) { clearSubItems(); m_Base = base; setOpen(true); }
 
-  bool mightContainSubItems() override { if (m_Base != nullptr) return true; return false; }
+  bool mightContainSubItems() override { if ((m_Base != nullptr) && (m_nField < 0)) return true; return false; }
   void itemOpennessChanged(bool isNowOpen) override;
   void paintItem(juce::Graphics& g, int width, int height) override;
   void itemClicked(const juce::MouseEvent&) override;
@@ -27,8 +28,7 @@ public:
 private:
   GeoBase* m_Base;
   GeoBase::Feature m_Feature;
-  juce::String m_AttName;
-  juce::String m_AttValue;
+  int m_nField;
 };
 
 class SelTreeViewer  : public juce::TreeView, public juce::ActionBroadcaster {
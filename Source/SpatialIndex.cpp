@@ -0,0 +1,392 @@
+//==============================================================================
+// SpatialIndex.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <JuceHeader.h>
+#include "SpatialIndex.h"
+
+//==============================================================================
+// Entete du fichier index, suivie du chemin de la source (aligne sur 8 octets),
+// des enveloppes, des fils des noeuds et des FID
+//==============================================================================
+struct SpatialIndexHeader {
+	char				Magic[4];
+	juce::uint32	Version;
+	juce::uint32	NodeSize;
+	juce::uint32	PathSize;
+	juce::int64	SourceSize;
+	juce::int64	SourceTime;
+	juce::uint64	NumItems;
+	juce::uint64	NumNodes;
+};
+static const char IndexMagic[4] = { 'G', 'M', 'I', 'X' };
+static const juce::uint32 IndexVersion = 1;
+
+SpatialIndex::SpatialIndex(int nodeSize)
+{
+	m_nNodeSize = (nodeSize < 2) ? 2 : nodeSize;
+	Clear();
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+//==============================================================================
+// Remise a zero
+//==============================================================================
+void SpatialIndex::Clear()
+{
+	m_nNumItems = m_nNumNodes = 0;
+	m_Box.clear();
+	m_Child.clear();
+	m_Fid.clear();
+	m_pBox = nullptr;
+	m_pChild = nullptr;
+	m_pFid = nullptr;
+	m_File.reset();
+	m_Stack.clear();
+	m_Queue.clear();
+	m_nLeafPos = m_nLeafEnd = 0;
+	m_dX = m_dY = 0.;
+}
+
+//==============================================================================
+// Construction STR : tri des centres en X, decoupage en tranches verticales,
+// tri en Y dans chaque tranche, puis regroupement des noeuds par m_nNodeSize
+//==============================================================================
+void SpatialIndex::Build(const std::vector<OGREnvelope>& env, const std::vector<GIntBig>& fid)
+{
+	Clear();
+	size_t n = env.size();
+	if (n == 0)
+		return;
+	const size_t M = (size_t)m_nNodeSize;
+	std::vector<size_t> order(n);
+	for (size_t i = 0; i < n; i++)
+		order[i] = i;
+
+	std::vector<double> cx(n), cy(n);
+	for (size_t i = 0; i < n; i++) {
+		cx[i] = (env[i].MinX + env[i].MaxX) * 0.5;
+		cy[i] = (env[i].MinY + env[i].MaxY) * 0.5;
+	}
+	std::sort(order.begin(), order.end(), [&cx](size_t a, size_t b) { return cx[a] < cx[b]; });
+	size_t numLeaves = (n + M - 1) / M;
+	size_t numSlices = (size_t)ceil(sqrt((double)numLeaves));
+	size_t sliceSize = numSlices * M;
+	for (size_t s = 0; s < n; s += sliceSize) {
+		size_t e = std::min(n, s + sliceSize);
+		std::sort(order.begin() + s, order.begin() + e, [&cy](size_t a, size_t b) { return cy[a] < cy[b]; });
+	}
+	if (fid.size() == n) {
+		for (size_t s = 0; s < n; s += M) {
+			size_t e = std::min(n, s + M);
+			std::sort(order.begin() + s, order.begin() + e, [&fid](size_t a, size_t b) { return fid[a] < fid[b]; });
+		}
+	}
+
+	// Niveau des elements
+	m_Box.reserve(n + n / (M - 1) + 2);
+	m_Fid.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		m_Box.push_back(env[order[i]]);
+		m_Fid[i] = (fid.size() == n) ? fid[order[i]] : (GIntBig)order[i];
+	}
+
+	// Niveaux superieurs : au moins un noeud au-dessus des elements
+	size_t levelStart = 0, levelEnd = n;
+	do {
+		for (size_t i = levelStart; i < levelEnd; i += M) {
+			size_t e = std::min(levelEnd, i + M);
+			OGREnvelope box;
+			for (size_t j = i; j < e; j++)
+				box.Merge(m_Box[j]);
+			m_Box.push_back(box);
+			m_Child.push_back((GIntBig)i);
+			m_Child.push_back((GIntBig)e);
+		}
+		levelStart = levelEnd;
+		levelEnd = m_Box.size();
+	} while (levelEnd - levelStart > 1);
+
+	m_nNumItems = n;
+	m_nNumNodes = m_Box.size();
+	m_pBox = m_Box.data();
+	m_pChild = m_Child.data();
+	m_pFid = m_Fid.data();
+}
+
+//==============================================================================
+// Nom du fichier index d'un layer dans le repertoire des index
+//==============================================================================
+std::string SpatialIndex::IndexFilename(const std::string& folder, const std::string& source, int layer)
+{
+	if ((folder.size() < 1) || (!juce::File::isAbsolutePath(source)))
+		return "";
+	juce::String name = juce::String::toHexString(juce::String(source).hashCode64()) + "_" + juce::String(layer) + ".idx";
+	return juce::File(folder).getChildFile(name).getFullPathName().toStdString();
+}
+
+//==============================================================================
+// Ecriture de l'index : un fichier temporaire est renomme a la fin
+//==============================================================================
+bool SpatialIndex::Save(const std::string& filename, const std::string& source) const
+{
+	if ((filename.size() < 1) || (m_nNumNodes == 0) || (!juce::File::isAbsolutePath(source)))
+		return false;
+	juce::File src(source), file(filename);
+	if (!src.existsAsFile())
+		return false;
+	if (!file.getParentDirectory().createDirectory())
+		return false;
+	juce::File tmp = file.getSiblingFile(file.getFileName() + ".tmp");
+	tmp.deleteFile();
+
+	SpatialIndexHeader header;
+	memcpy(header.Magic, IndexMagic, sizeof(IndexMagic));
+	header.Version = IndexVersion;
+	header.NodeSize = (juce::uint32)m_nNodeSize;
+	header.PathSize = (juce::uint32)((source.size() + 8) & ~(size_t)7);
+	header.SourceSize = src.getSize();
+	header.SourceTime = src.getLastModificationTime().toMilliseconds();
+	header.NumItems = m_nNumItems;
+	header.NumNodes = m_nNumNodes;
+	std::vector<char> path(header.PathSize, 0);
+	memcpy(path.data(), source.data(), source.size());
+	{
+		juce::FileOutputStream out(tmp);
+		if (!out.openedOk())
+			return false;
+		bool ok = out.write(&header, sizeof(header));
+		ok &= out.write(path.data(), path.size());
+		ok &= out.write(m_pBox, m_nNumNodes * sizeof(OGREnvelope));
+		ok &= out.write(m_pChild, (m_nNumNodes - m_nNumItems) * 2 * sizeof(GIntBig));
+		ok &= out.write(m_pFid, m_nNumItems * sizeof(GIntBig));
+		out.flush();
+		if ((!ok) || out.getStatus().failed()) {
+			tmp.deleteFile();
+			return false;
+		}
+	}
+	return tmp.moveFileTo(file);
+}
+
+//==============================================================================
+// Lecture de l'index : le fichier est projete en memoire, sans copie
+// Renvoie false si l'index n'existe pas ou ne correspond plus a la source
+//==============================================================================
+bool SpatialIndex::Load(const std::string& filename, const std::string& source)
+{
+	Clear();
+	if ((filename.size() < 1) || (!juce::File::isAbsolutePath(source)))
+		return false;
+	juce::File src(source), file(filename);
+	if ((!src.existsAsFile()) || (!file.existsAsFile()))
+		return false;
+	std::unique_ptr<juce::MemoryMappedFile> map(new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+	const char* data = (const char*)map->getData();
+	size_t size = map->getSize();
+	if ((data == nullptr) || (size < sizeof(SpatialIndexHeader)))
+		return false;
+	SpatialIndexHeader header;
+	memcpy(&header, data, sizeof(header));
+	if ((memcmp(header.Magic, IndexMagic, sizeof(IndexMagic)) != 0) || (header.Version != IndexVersion) ||
+		(header.NodeSize != (juce::uint32)m_nNodeSize) || (header.SourceSize != src.getSize()) ||
+		(header.SourceTime != src.getLastModificationTime().toMilliseconds()) ||
+		(header.NumItems == 0) || (header.NumNodes <= header.NumItems) || (header.PathSize % 8 != 0))
+		return false;
+	size_t expected = sizeof(header) + header.PathSize + header.NumNodes * sizeof(OGREnvelope) +
+		(header.NumNodes - header.NumItems) * 2 * sizeof(GIntBig) + header.NumItems * sizeof(GIntBig);
+	if ((size != expected) || (strncmp(data + sizeof(header), source.c_str(), header.PathSize) != 0))
+		return false;
+
+	const char* p = data + sizeof(header) + header.PathSize;
+	m_pBox = (const OGREnvelope*)p;
+	p += header.NumNodes * sizeof(OGREnvelope);
+	m_pChild = (const GIntBig*)p;
+	p += (header.NumNodes - header.NumItems) * 2 * sizeof(GIntBig);
+	m_pFid = (const GIntBig*)p;
+	m_nNumItems = (size_t)header.NumItems;
+	m_nNumNodes = (size_t)header.NumNodes;
+	m_File = std::move(map);
+	return true;
+}
+
+//==============================================================================
+// Recherche de tous les elements intersectant un rectangle
+//==============================================================================
+void SpatialIndex::Search(const OGREnvelope& rect, std::vector<size_t>& items) const
+{
+	items.clear();
+	if (m_nNumNodes <= m_nNumItems)
+		return;
+	std::vector<size_t> stack;
+	stack.push_back(m_nNumNodes - 1);
+	while (stack.size() > 0) {
+		size_t node = stack.back();
+		stack.pop_back();
+		if (!Intersects(m_pBox[node], rect))
+			continue;
+		if (node < m_nNumItems) {
+			items.push_back(node);
+			continue;
+		}
+		size_t first = (size_t)m_pChild[2 * (node - m_nNumItems)], last = (size_t)m_pChild[2 * (node - m_nNumItems) + 1];
+		for (size_t i = last; i > first; i--)
+			stack.push_back(i - 1);
+	}
+}
+
+//==============================================================================
+// Distance d'un point a une enveloppe (nulle si le point est dans l'enveloppe)
+//==============================================================================
+double SpatialIndex::Distance(const OGREnvelope& a, double x, double y)
+{
+	double dx = std::max(0., std::max(a.MinX - x, x - a.MaxX));
+	double dy = std::max(0., std::max(a.MinY - y, y - a.MaxY));
+	return sqrt(dx * dx + dy * dy);
+}
+
+//==============================================================================
+// Recherche des plus proches voisins, en parcourant d'abord le meilleur candidat
+// La file contient des noeuds et des elements ordonnes par la distance a leur
+// enveloppe, et des elements ordonnes par leur distance exacte : un element
+// sorti de la file avec sa distance exacte est plus proche que tout le reste
+//==============================================================================
+size_t SpatialIndex::Nearest(double x, double y, double maxDist, size_t k, const std::function<double(size_t)>& distance,
+														 std::vector<std::pair<double, size_t> >& items) const
+{
+	struct Candidate {
+		double	Dist;
+		size_t	Node;
+		bool		Exact;
+		bool operator<(const Candidate& c) const { return Dist > c.Dist; }	// Plus petite distance en tete
+	};
+	items.clear();
+	if ((m_nNumNodes <= m_nNumItems) || (k < 1))
+		return 0;
+	std::priority_queue<Candidate> queue;
+	size_t root = m_nNumNodes - 1;
+	double d = Distance(m_pBox[root], x, y);
+	if (d <= maxDist)
+		queue.push({ d, root, false });
+	while (queue.size() > 0) {
+		Candidate c = queue.top();
+		if ((items.size() >= k) && (c.Dist > items.back().first))
+			break;
+		queue.pop();
+		if (c.Exact) {
+			items.push_back(std::pair<double, size_t>(c.Dist, c.Node));
+			continue;
+		}
+		if (c.Node < m_nNumItems) {
+			d = distance(c.Node);
+			if ((d >= 0.) && (d <= maxDist))
+				queue.push({ d, c.Node, true });
+			continue;
+		}
+		size_t first = (size_t)m_pChild[2 * (c.Node - m_nNumItems)], last = (size_t)m_pChild[2 * (c.Node - m_nNumItems) + 1];
+		for (size_t i = first; i < last; i++) {
+			d = Distance(m_pBox[i], x, y);
+			if (d <= maxDist)
+				queue.push({ d, i, false });
+		}
+	}
+	return items.size();
+}
+
+//==============================================================================
+// Debut d'une recherche
+//==============================================================================
+void SpatialIndex::Start(const OGREnvelope& rect)
+{
+	m_Rect = rect;
+	m_Stack.clear();
+	m_nLeafPos = m_nLeafEnd = 0;
+	if (m_nNumNodes <= m_nNumItems)
+		return;
+	size_t root = m_nNumNodes - 1;
+	if (Intersects(m_pBox[root], m_Rect))
+		m_Stack.push_back(root);
+}
+
+//==============================================================================
+// Element suivant intersectant le rectangle de recherche
+//==============================================================================
+bool SpatialIndex::Next(size_t& item)
+{
+	while (true) {
+		while (m_nLeafPos < m_nLeafEnd) {
+			size_t i = m_nLeafPos++;
+			if (Intersects(m_pBox[i], m_Rect)) {
+				item = i;
+				return true;
+			}
+		}
+		if (m_Stack.size() < 1)
+			return false;
+		size_t node = m_Stack.back();
+		m_Stack.pop_back();
+		size_t first = (size_t)m_pChild[2 * (node - m_nNumItems)], last = (size_t)m_pChild[2 * (node - m_nNumItems) + 1];
+		if (first < m_nNumItems) {	// Les fils sont des elements
+			m_nLeafPos = first;
+			m_nLeafEnd = last;
+			continue;
+		}
+		for (size_t i = last; i > first; i--)	// Ordre inverse pour visiter les fils dans l'ordre
+			if (Intersects(m_pBox[i - 1], m_Rect))
+				m_Stack.push_back(i - 1);
+	}
+}
+
+//==============================================================================
+// Debut d'une recherche par distance croissante a (x, y)
+// Les noeuds sont ouverts du plus proche au plus eloigne : les premiers elements
+// sont renvoyes sans parcourir tout l'index
+//==============================================================================
+void SpatialIndex::StartNearest(const OGREnvelope& rect, double x, double y)
+{
+	m_Rect = rect;
+	m_dX = x;
+	m_dY = y;
+	m_Queue.clear();
+	m_Stack.clear();
+	m_nLeafPos = m_nLeafEnd = 0;
+	if (m_nNumNodes <= m_nNumItems)
+		return;
+	size_t root = m_nNumNodes - 1;
+	if (Intersects(m_pBox[root], m_Rect))
+		m_Queue.push_back(std::pair<double, size_t>(Distance(m_pBox[root], x, y), root));
+}
+
+//==============================================================================
+// Element suivant de la recherche par distance
+//==============================================================================
+bool SpatialIndex::NextNearest(size_t& item)
+{
+	auto farther = [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first > b.first; };
+	while (m_Queue.size() > 0) {
+		std::pop_heap(m_Queue.begin(), m_Queue.end(), farther);
+		size_t node = m_Queue.back().second;
+		m_Queue.pop_back();
+		if (node < m_nNumItems) {
+			item = node;
+			return true;
+		}
+		size_t first = (size_t)m_pChild[2 * (node - m_nNumItems)], last = (size_t)m_pChild[2 * (node - m_nNumItems) + 1];
+		for (size_t i = first; i < last; i++) {
+			if (!Intersects(m_pBox[i], m_Rect))
+				continue;
+			m_Queue.push_back(std::pair<double, size_t>(Distance(m_pBox[i], m_dX, m_dY), i));
+			std::push_heap(m_Queue.begin(), m_Queue.end(), farther);
+		}
+	}
+	return false;
+}
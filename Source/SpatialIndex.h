@@ -0,0 +1,79 @@
+//==============================================================================
+// SpatialIndex.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ogrsf_frmts.h"
+
+namespace juce { class MemoryMappedFile; }
+
+//==============================================================================
+// SpatialIndex : R-tree compact construit en une fois (Sort-Tile-Recursive)
+// Les noeuds sont ranges niveau par niveau dans des tableaux contigus : les
+// elements d'abord (dans l'ordre des feuilles), puis les niveaux superieurs.
+// Les tableaux peuvent etre lus directement dans un fichier index projete en memoire
+//==============================================================================
+class SpatialIndex {
+public:
+	SpatialIndex(int nodeSize = 16);
+	virtual ~SpatialIndex();
+
+	void Clear();
+	// Construction : dans une feuille, les elements sont tries par FID pour des lectures sequentielles
+	void Build(const std::vector<OGREnvelope>& env, const std::vector<GIntBig>& fid);
+	size_t Size() const { return m_nNumItems; }
+	OGREnvelope Bounds() const { if (m_nNumNodes > 0) return m_pBox[m_nNumNodes - 1]; return OGREnvelope(); }
+	const OGREnvelope& Envelope(size_t item) const { return m_pBox[item]; }
+	GIntBig Fid(size_t item) const { return m_pFid[item]; }
+
+	// Fichier index : la source est identifiee par son chemin, sa taille et sa date de modification
+	static std::string IndexFilename(const std::string& folder, const std::string& source, int layer);
+	bool Save(const std::string& filename, const std::string& source) const;
+	bool Load(const std::string& filename, const std::string& source);
+
+	// Recherche de tous les elements intersectant rect, sans modifier la recherche incrementale
+	void Search(const OGREnvelope& rect, std::vector<size_t>& items) const;
+
+	// Recherche des k elements les plus proches de (x, y), a une distance au plus maxDist, par distance croissante
+	// distance renvoie la distance exacte a un element (negative en cas d'erreur) : elle n'est calculee que pour
+	// les elements dont l'enveloppe peut encore battre les resultats. Les ex-aequo du k-ieme sont aussi renvoyes
+	size_t Nearest(double x, double y, double maxDist, size_t k, const std::function<double(size_t)>& distance,
+								 std::vector<std::pair<double, size_t> >& items) const;
+
+	// Recherche incrementale : les elements sont renvoyes dans l'ordre des feuilles
+	void Start(const OGREnvelope& rect);
+	bool Next(size_t& item);
+	// Recherche incrementale par distance croissante de l'enveloppe des elements a (x, y)
+	void StartNearest(const OGREnvelope& rect, double x, double y);
+	bool NextNearest(size_t& item);
+
+protected:
+	int												m_nNodeSize;
+	size_t										m_nNumItems;
+	size_t										m_nNumNodes;
+	std::vector<OGREnvelope>	m_Box;			// Enveloppes des elements puis des noeuds
+	std::vector<GIntBig>			m_Child;		// Premier et dernier (exclu) fils de chaque noeud : 2 valeurs par noeud
+	std::vector<GIntBig>			m_Fid;			// FID des elements
+	const OGREnvelope*				m_pBox;			// Tableaux utilises : m_Box, m_Child, m_Fid ou fichier projete
+	const GIntBig*						m_pChild;
+	const GIntBig*						m_pFid;
+	std::unique_ptr<juce::MemoryMappedFile> m_File;
+	// Etat de la recherche
+	OGREnvelope								m_Rect;
+	std::vector<size_t>				m_Stack;		// Noeuds a visiter
+	size_t										m_nLeafPos, m_nLeafEnd;	// Elements de la feuille courante
+	std::vector<std::pair<double, size_t> >	m_Queue;	// Noeuds et elements a visiter, par distance (tas)
+	double										m_dX, m_dY;	// Point de depart de la recherche par distance
+
+	static bool Intersects(const OGREnvelope& a, const OGREnvelope& b)
+		{ return (a.MinX <= b.MaxX) && (a.MaxX >= b.MinX) && (a.MinY <= b.MaxY) && (a.MaxY >= b.MinY); }
+	static double Distance(const OGREnvelope& a, double x, double y);
+};
@@ -0,0 +1,170 @@
+//==============================================================================
+// TileCache.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "TileCache.h"
+
+//==============================================================================
+// Niveau de zoom : deux echelles a moins de 1e-6 octave partagent leurs tuiles
+//==============================================================================
+juce::int64 TileCache::Level(double scale)
+{
+	return (juce::int64)llround(log2(scale) * 1e6);
+}
+
+//==============================================================================
+// Empreinte (FNV-1a) de la representation d'un layer
+//==============================================================================
+juce::uint64 TileCache::StyleHash(const GeoBase::Repres& repres, bool batch)
+{
+	juce::uint64 h = 0xcbf29ce484222325ULL;
+	auto add = [&h](const void* data, size_t size) {
+		const juce::uint8* p = (const juce::uint8*)data;
+		for (size_t i = 0; i < size; i++) {
+			h ^= p[i];
+			h *= 0x100000001b3ULL;
+		}
+	};
+	add(&repres.PenColor, sizeof(repres.PenColor));
+	add(&repres.FillColor, sizeof(repres.FillColor));
+	add(&repres.PenSize, sizeof(repres.PenSize));
+	add(&repres.Decimation, sizeof(repres.Decimation));
+	add(&repres.SymbolSize, sizeof(repres.SymbolSize));
+	add(&batch, sizeof(batch));
+	return h;
+}
+
+void TileCache::SetBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_nBudget = budget;
+	Evict();
+}
+
+//==============================================================================
+// Repertoire du cache disque : un fichier vide desactive l'ecriture sur disque
+// Les tuiles deja presentes dans le nouveau repertoire sont effacees : elles
+// viennent d'une session precedente, dont les identifiants de layers sont reutilises
+//==============================================================================
+void TileCache::SetDiskCache(const juce::File& folder)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Folder.isDirectory())	// Les tuiles de l'ancien repertoire ne sont plus utilisees
+		DeleteTiles(m_Folder);
+	m_Folder = folder;
+	if (m_Folder == juce::File())
+		return;
+	m_Folder.createDirectory();
+	DeleteTiles(m_Folder);
+}
+
+void TileCache::DeleteTiles(const juce::File& folder, const juce::String& pattern)
+{
+	juce::Array<juce::File> files = folder.findChildFiles(juce::File::findFiles, false, pattern);
+	for (int i = 0; i < files.size(); i++)
+		files[i].deleteFile();
+}
+
+juce::File TileCache::TileFile(const Key& key)
+{
+	return m_Folder.getChildFile("L" + juce::String(key.Layer) + "_" + juce::String::toHexString((juce::int64)key.Style) + "_" +
+		juce::String(key.Level) + "_" + juce::String(key.X) + "_" + juce::String(key.Y) + ".png");
+}
+
+//==============================================================================
+// Recherche d'une tuile en memoire, puis sur disque
+//==============================================================================
+juce::Image TileCache::Find(const Key& key)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto iter = m_Map.find(key);
+	if (iter != m_Map.end()) {
+		m_List.splice(m_List.begin(), m_List, iter->second);
+		return iter->second->second;
+	}
+	if (!m_Folder.isDirectory())
+		return juce::Image();
+	juce::File file = TileFile(key);
+	if (!file.existsAsFile())
+		return juce::Image();
+	juce::Image tile = juce::ImageFileFormat::loadFrom(file);
+	if (!tile.isValid())
+		return juce::Image();
+	m_List.emplace_front(key, tile);
+	m_Map[key] = m_List.begin();
+	m_nSize += (size_t)tile.getWidth() * tile.getHeight() * 4;
+	Evict();
+	return tile;
+}
+
+//==============================================================================
+// Ajout d'une tuile
+//==============================================================================
+void TileCache::Insert(const Key& key, const juce::Image& tile)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto iter = m_Map.find(key);
+	if (iter != m_Map.end()) {
+		m_nSize -= (size_t)iter->second->second.getWidth() * iter->second->second.getHeight() * 4;
+		m_List.erase(iter->second);
+		m_Map.erase(iter);
+	}
+	m_List.emplace_front(key, tile);
+	m_Map[key] = m_List.begin();
+	m_nSize += (size_t)tile.getWidth() * tile.getHeight() * 4;
+	Evict();
+}
+
+//==============================================================================
+// Retrait des tuiles les plus anciennes, ecrites sur disque si besoin
+//==============================================================================
+void TileCache::Evict()
+{
+	while ((m_nSize > m_nBudget) && (m_List.size() > 1)) {
+		auto last = std::prev(m_List.end());
+		if (m_Folder.isDirectory()) {
+			juce::File file = TileFile(last->first);
+			if (!file.existsAsFile()) {
+				juce::FileOutputStream stream(file);
+				juce::PNGImageFormat png;
+				if (stream.openedOk())
+					png.writeImageToStream(last->second, stream);
+			}
+		}
+		m_nSize -= (size_t)last->second.getWidth() * last->second.getHeight() * 4;
+		m_Map.erase(last->first);
+		m_List.pop_back();
+	}
+}
+
+//==============================================================================
+// Retrait de toutes les tuiles d'un layer (changement de representation)
+//==============================================================================
+void TileCache::InvalidateLayer(int layerId)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto iter = m_List.begin(); iter != m_List.end(); ) {
+		if (iter->first.Layer != layerId) {
+			++iter;
+			continue;
+		}
+		m_nSize -= (size_t)iter->second.getWidth() * iter->second.getHeight() * 4;
+		m_Map.erase(iter->first);
+		iter = m_List.erase(iter);
+	}
+	if (m_Folder.isDirectory())
+		DeleteTiles(m_Folder, "L" + juce::String(layerId) + "_*.png");
+}
+
+void TileCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_List.clear();
+	m_Map.clear();
+	m_nSize = 0;
+	if (m_Folder.isDirectory())
+		DeleteTiles(m_Folder);
+}
@@ -0,0 +1,68 @@
+//==============================================================================
+// TileCache.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <JuceHeader.h>
+#include "GeoBase.h"
+
+//==============================================================================
+// TileCache : cache des tuiles deja dessinees pour chaque layer vectoriel
+// Une tuile est identifiee par (niveau de zoom, colonne, ligne, layer, style).
+// Les tuiles les moins recentes sont retirees de la memoire et, si un
+// repertoire est fixe, ecrites sur disque.
+//==============================================================================
+class TileCache {
+public:
+	static const int TileSize = 256;
+
+	typedef struct Key {
+		juce::int64		Level;	// Niveau de zoom : log2(echelle) quantifie
+		int						X, Y;		// Colonne et ligne de la tuile
+		int						Layer;	// Identifiant du layer
+		juce::uint64	Style;	// Empreinte de la representation du layer
+		bool operator==(const Key& k) const { return (Level == k.Level) && (X == k.X) && (Y == k.Y) && (Layer == k.Layer) && (Style == k.Style); }
+	} Key;
+
+	TileCache(size_t budget = 256 * 1024 * 1024) { m_nBudget = budget; m_nSize = 0; }
+
+	void SetBudget(size_t budget);
+	void SetDiskCache(const juce::File& folder);
+	juce::File DiskCache() { return m_Folder; }
+
+	juce::Image Find(const Key& key);
+	void Insert(const Key& key, const juce::Image& tile);
+	void InvalidateLayer(int layerId);
+	void Clear();
+
+	static juce::int64 Level(double scale);
+	static juce::uint64 StyleHash(const GeoBase::Repres& repres, bool batch);
+
+private:
+	struct KeyHash {
+		size_t operator()(const Key& k) const {
+			juce::uint64 h = (juce::uint64)k.Level * 0x9E3779B97F4A7C15ULL;
+			h ^= ((juce::uint64)(juce::uint32)k.X << 32) ^ (juce::uint32)k.Y;
+			h ^= k.Style + ((juce::uint64)k.Layer << 16);
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+	typedef std::list<std::pair<Key, juce::Image> > List;
+	List															m_List;		// De la plus recente a la plus ancienne
+	std::unordered_map<Key, List::iterator, KeyHash>	m_Map;
+	size_t														m_nSize;
+	size_t														m_nBudget;
+	juce::File												m_Folder;	// Repertoire du cache disque (optionnel)
+	std::mutex												m_Mutex;
+
+	void Evict();
+	juce::File TileFile(const Key& key);
+	static void DeleteTiles(const juce::File& folder, const juce::String& pattern = "L*.png");
+};
@@ -0,0 +1,581 @@
+//==============================================================================
+// VectorRenderer.cpp
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#include "VectorRenderer.h"
+
+#if defined(__AVX2__)
+#define GDALMAP_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GDALMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+VectorRenderer::VectorRenderer()
+{
+	m_dX0 = m_dY0 = 0.;
+	m_dScale = 1.0;
+	m_Pt = nullptr;
+	m_Pix = nullptr;
+	m_nPtAlloc = 0;
+	m_bFill = false;
+	m_bBatch = false;
+	m_nPathPoints = 0;
+	m_fTolerance = 0.f;
+	m_nNumObjects = 0;
+	m_BatchRepres = GeoBase::Repres();
+}
+
+VectorRenderer::~VectorRenderer()
+{
+	if (m_Pt != nullptr)
+		delete[] m_Pt;
+	if (m_Pix != nullptr)
+		delete[] m_Pix;
+}
+
+bool VectorRenderer::AllocPoints(int numPt)
+{
+	m_Path.preallocateSpace(3 * numPt + 1);
+	if (numPt < m_nPtAlloc)
+		return true;
+	if (m_Pt != nullptr)
+		delete[] m_Pt;
+	if (m_Pix != nullptr)
+		delete[] m_Pix;
+	m_Pt = new double[numPt * 2];
+	m_Pix = new float[numPt * 2];
+	if ((m_Pt == nullptr) || (m_Pix == nullptr))
+		return false;
+	m_nPtAlloc = numPt;
+	return true;
+}
+
+//==============================================================================
+// Conversion terrain -> pixel : X = (x - X0) / scale ; Y = (Y0 - y) / scale
+// Les sommets sont entrelaces (x0, y0, x1, y1 ...) ; le resultat est identique
+// a la boucle scalaire
+//==============================================================================
+void VectorRenderer::ToPixel(const double* pt, int n, const double& X0, const double& Y0, const double& scale, float* pix)
+{
+	int i = 0;
+#if defined(GDALMAP_AVX2)
+	const __m256d origin = _mm256_setr_pd(X0, Y0, X0, Y0);
+	const __m256d factor = _mm256_setr_pd(scale, -scale, scale, -scale);
+	for (; i + 4 <= n; i += 4) {
+		__m256d a = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(&pt[2 * i]), origin), factor);
+		__m256d b = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(&pt[2 * i + 4]), origin), factor);
+		_mm_storeu_ps(&pix[2 * i], _mm256_cvtpd_ps(a));
+		_mm_storeu_ps(&pix[2 * i + 4], _mm256_cvtpd_ps(b));
+	}
+#elif defined(GDALMAP_SSE2)
+	const __m128d origin = _mm_setr_pd(X0, Y0);
+	const __m128d factor = _mm_setr_pd(scale, -scale);
+	for (; i + 2 <= n; i += 2) {
+		__m128 a = _mm_cvtpd_ps(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(&pt[2 * i]), origin), factor));
+		__m128 b = _mm_cvtpd_ps(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(&pt[2 * i + 2]), origin), factor));
+		_mm_storeu_ps(&pix[2 * i], _mm_movelh_ps(a, b));
+	}
+#endif
+	for (; i < n; i++) {
+		pix[2 * i] = (float)((pt[2 * i] - X0) / scale);
+		pix[2 * i + 1] = (float)((Y0 - pt[2 * i + 1]) / scale);
+	}
+}
+
+//==============================================================================
+// Distance (au carre) des sommets intermediaires de la polyligne au segment
+// [a, b] : renvoie true si tous sont a moins de la tolerance
+//==============================================================================
+static bool InCorridor(const float* pix, int a, int b, float tol2)
+{
+	float ax = pix[2 * a], ay = pix[2 * a + 1];
+	float sx = pix[2 * b] - ax, sy = pix[2 * b + 1] - ay;
+	float len2 = sx * sx + sy * sy;
+	for (int k = a + 1; k < b; k++) {
+		float dx = pix[2 * k] - ax, dy = pix[2 * k + 1] - ay;
+		float t = (len2 > 0.f) ? (dx * sx + dy * sy) / len2 : 0.f;
+		if (t < 0.f) t = 0.f;
+		if (t > 1.f) t = 1.f;
+		dx -= t * sx;
+		dy -= t * sy;
+		if (dx * dx + dy * dy >= tol2)
+			return false;
+	}
+	return true;
+}
+
+//==============================================================================
+// Ajout d'une polyligne (coordonnees pixel) au path
+// Avec une tolerance, le segment partant du dernier sommet emis est prolonge
+// tant que tous les sommets qu'il remplace restent a moins de la tolerance du
+// segment (comme Douglas-Peucker, mais au vol). Le nombre de sommets remplaces
+// par un segment est borne pour garder un cout lineaire. Les extremites sont conservees.
+//==============================================================================
+void VectorRenderer::AddPolyline(const float* pix, int numPt, bool closed)
+{
+	if (numPt < 1)
+		return;
+	m_nPathPoints += numPt;
+	m_Path.startNewSubPath(pix[0], pix[1]);
+	if (m_fTolerance <= 0.f) {
+		for (int i = 1; i < numPt; i++)
+			m_Path.lineTo(pix[2 * i], pix[2 * i + 1]);
+		if (closed)
+			m_Path.closeSubPath();
+		return;
+	}
+
+	const float tol2 = m_fTolerance * m_fTolerance;
+	const int maxWindow = 32;	// Nombre maximal de sommets remplaces par un segment
+	int anchor = 0;		// Dernier sommet emis
+	int end = 0;			// Dernier sommet pouvant terminer le segment issu de anchor
+	for (int i = 1; i < numPt; i++) {
+		if ((i - anchor > maxWindow) || (!InCorridor(pix, anchor, i, tol2))) {
+			m_Path.lineTo(pix[2 * end], pix[2 * end + 1]);
+			anchor = end;
+		}
+		end = i;
+	}
+	if (end != anchor)
+		m_Path.lineTo(pix[2 * end], pix[2 * end + 1]);
+	if (closed)
+		m_Path.closeSubPath();
+}
+
+//==============================================================================
+// Benchmark du noyau de conversion par rapport a la boucle point par point
+//==============================================================================
+juce::String VectorRenderer::Benchmark(int numPoints, int numLoops)
+{
+	std::vector<double> pt(2 * (size_t)numPoints);
+	std::vector<float> pix(2 * (size_t)numPoints);
+	juce::Random random(42);
+	for (size_t i = 0; i < pt.size(); i++)
+		pt[i] = 650000. + random.nextDouble() * 100000.;
+	const double X0 = 660000., Y0 = 6900000., scale = 1.7;
+
+	juce::Path path;
+	path.preallocateSpace(3 * numPoints + 1);
+	double tLoop = 0., tKernel = 0., tConvLoop = 0., tConvKernel = 0.;
+	for (int loop = 0; loop < numLoops; loop++) {
+		// Boucle d'origine : conversion et lineTo point par point
+		juce::int64 t0 = juce::Time::getHighResolutionTicks();
+		path.clear();
+		path.startNewSubPath((pt[0] - X0) / scale, (Y0 - pt[1]) / scale);
+		for (int i = 1; i < numPoints; i++)
+			path.lineTo((pt[2 * i] - X0) / scale, (Y0 - pt[2 * i + 1]) / scale);
+		juce::int64 t1 = juce::Time::getHighResolutionTicks();
+		// Noyau vectoriel puis construction du path a partir du tampon converti
+		ToPixel(pt.data(), numPoints, X0, Y0, scale, pix.data());
+		path.clear();
+		path.startNewSubPath(pix[0], pix[1]);
+		for (int i = 1; i < numPoints; i++)
+			path.lineTo(pix[2 * i], pix[2 * i + 1]);
+		juce::int64 t2 = juce::Time::getHighResolutionTicks();
+		// Conversion seule
+		for (int i = 0; i < numPoints; i++) {
+			pix[2 * i] = (float)((pt[2 * i] - X0) / scale);
+			pix[2 * i + 1] = (float)((Y0 - pt[2 * i + 1]) / scale);
+		}
+		juce::int64 t3 = juce::Time::getHighResolutionTicks();
+		ToPixel(pt.data(), numPoints, X0, Y0, scale, pix.data());
+		juce::int64 t4 = juce::Time::getHighResolutionTicks();
+		tLoop += juce::Time::highResolutionTicksToSeconds(t1 - t0);
+		tKernel += juce::Time::highResolutionTicksToSeconds(t2 - t1);
+		tConvLoop += juce::Time::highResolutionTicksToSeconds(t3 - t2);
+		tConvKernel += juce::Time::highResolutionTicksToSeconds(t4 - t3);
+	}
+
+	// Verification : le noyau doit donner le meme resultat que la boucle scalaire
+	int numDiff = 0;
+	for (int i = 0; i < numPoints; i++) {
+		if (pix[2 * i] != (float)((pt[2 * i] - X0) / scale)) numDiff++;
+		if (pix[2 * i + 1] != (float)((Y0 - pt[2 * i + 1]) / scale)) numDiff++;
+	}
+
+#if defined(GDALMAP_AVX2)
+	juce::String simd = "AVX2";
+#elif defined(GDALMAP_SSE2)
+	juce::String simd = "SSE2";
+#else
+	juce::String simd = "scalar";
+#endif
+	juce::String result = juce::String(numPoints) + " points x " + juce::String(numLoops) + " (" + simd + ")\n";
+	result += "Path, point by point : " + juce::String(tLoop * 1000. / numLoops, 2) + " ms\n";
+	result += "Path, kernel : " + juce::String(tKernel * 1000. / numLoops, 2) + " ms\n";
+	result += "Conversion, point by point : " + juce::String(tConvLoop * 1000. / numLoops, 2) + " ms\n";
+	result += "Conversion, kernel : " + juce::String(tConvKernel * 1000. / numLoops, 2) + " ms\n";
+	result += "Differences : " + juce::String(numDiff);
+	return result;
+}
+
+//==============================================================================
+// Dessin d'un lot de features
+// Les geometries projetees sont conservees dans le cache du layer : quand les
+// identifiants sont connus par l'index du layer, un feature deja en cache n'est
+// pas relu par OGR ; sinon, seule la transformation est evitee
+//==============================================================================
+bool VectorRenderer::DrawFeatures(GeoBase::VectorLayer* poLayer, juce::Graphics& g, GeoBase::Transformation* transfo, int maxFeatures,
+																	OGRLayer* source)
+{
+	for (int i = 0; i < maxFeatures; i++) {
+		if (!poLayer->FastSpatialFilter()) {
+			GIntBig id;
+			OGREnvelope env;
+			if (!poLayer->GetNextFeatureId(id, env)) {
+				Flush(g);
+				return false;
+			}
+			DrawFeatureId(poLayer, g, transfo, id, source);
+			continue;
+		}
+		OGRFeature* poFeature = (source != nullptr) ? source->GetNextFeature() : poLayer->GetNextFeature();
+		if (poFeature == nullptr) {
+			Flush(g);
+			return false;
+		}
+		DrawFeature(poLayer, g, transfo, poFeature);
+		OGRFeature::DestroyFeature(poFeature);
+	}
+	return true;
+}
+
+//==============================================================================
+// Dessin d'un feature deja lu : sa geometrie peut etre modifiee (projection)
+//==============================================================================
+void VectorRenderer::DrawFeature(GeoBase::VectorLayer* poLayer, juce::Graphics& g, GeoBase::Transformation* transfo, OGRFeature* poFeature)
+{
+	GeometryCache* cache = poLayer->Cache();
+	const FlatGeometry* geom = cache->Find(poFeature->GetFID());
+	if (geom == nullptr)
+		geom = LoadGeometry(poFeature, transfo, cache);
+	if (geom != nullptr)
+		DrawFeature(g, *geom, poLayer->m_Repres);
+	Count(geom);
+}
+
+void VectorRenderer::CacheFeature(GeoBase::VectorLayer* poLayer, GeoBase::Transformation* transfo, OGRFeature* poFeature)
+{
+	GeometryCache* cache = poLayer->Cache();
+	if (cache->Find(poFeature->GetFID()) == nullptr)
+		LoadGeometry(poFeature, transfo, cache);
+}
+
+//==============================================================================
+// Dessin des features d'une liste a partir de l'indice index
+// Renvoie false quand la liste est terminee
+//==============================================================================
+bool VectorRenderer::DrawFeatures(GeoBase::VectorLayer* poLayer, juce::Graphics& g, GeoBase::Transformation* transfo,
+																	std::vector<GeoBase::Feature>& features, size_t& index, int maxFeatures)
+{
+	for (int i = 0; i < maxFeatures; i++) {
+		if (index >= features.size()) {
+			Flush(g);
+			return false;
+		}
+		DrawFeatureId(poLayer, g, transfo, features[index].Id());
+		index++;
+	}
+	return true;
+}
+
+//==============================================================================
+// Dessin d'un feature a partir de son identifiant (cache ou lecture OGR)
+//==============================================================================
+void VectorRenderer::DrawFeatureId(GeoBase::VectorLayer* poLayer, juce::Graphics& g, GeoBase::Transformation* transfo, GIntBig id,
+																	 OGRLayer* source)
+{
+	GeometryCache* cache = poLayer->Cache();
+	const FlatGeometry* geom = cache->Find(id);
+	if (geom == nullptr) {
+		OGRFeature* poFeature = ((source != nullptr) ? source : poLayer->GetOGRLayer())->GetFeature(id);
+		geom = LoadGeometry(poFeature, transfo, cache);
+		OGRFeature::DestroyFeature(poFeature);
+	}
+	if (geom != nullptr)
+		DrawFeature(g, *geom, poLayer->m_Repres);
+	Count(geom);
+}
+
+//==============================================================================
+// Comptage d'un objet dessine : avec une zone de comptage, un objet qui deborde
+// sur plusieurs tuiles n'est compte que dans la tuile de son coin haut gauche
+//==============================================================================
+void VectorRenderer::Count(const FlatGeometry* geom)
+{
+	if (!m_CountEnv.IsInit()) {
+		m_nNumObjects++;
+		return;
+	}
+	if (geom == nullptr)
+		return;
+	if ((geom->Env.MinX >= m_CountEnv.MinX) && (geom->Env.MinX < m_CountEnv.MaxX) &&
+			(geom->Env.MaxY <= m_CountEnv.MaxY) && (geom->Env.MaxY > m_CountEnv.MinY))
+		m_nNumObjects++;
+}
+
+//==============================================================================
+// Projection d'une geometrie et ajout dans le cache
+//==============================================================================
+const FlatGeometry* VectorRenderer::LoadGeometry(OGRFeature* poFeature, GeoBase::Transformation* transfo, GeometryCache* cache)
+{
+	if (poFeature == nullptr)
+		return nullptr;
+	OGRGeometry* poGeom = poFeature->GetGeometryRef();
+	if (poGeom == nullptr)
+		return nullptr;
+	if (!transfo->Transform(poGeom))
+		return nullptr;
+	if (!m_Flat.Set(poGeom))
+		return nullptr;
+	const FlatGeometry* geom = cache->Insert(poFeature->GetFID(), m_Flat);
+	if (geom != nullptr)
+		return geom;
+	return &m_Flat;
+}
+
+//==============================================================================
+// Dessin d'un feature deja transforme dans le systeme de la vue
+// En mode par lots, la geometrie est ajoutee au path en attente, qui est dessine
+// quand le style change ou quand il devient trop gros
+//==============================================================================
+void VectorRenderer::DrawFeature(juce::Graphics& g, const FlatGeometry& geom, const GeoBase::Repres& repres)
+{
+	const int maxBatchPoints = 50000;
+	const OGREnvelope& env = geom.Env;
+	juce::Rectangle<int> frame = juce::Rectangle<int>((int)round((env.MinX - m_dX0) / m_dScale), (int)round((m_dY0 - env.MaxY) / m_dScale),
+		(int)round((env.MaxX - env.MinX) / m_dScale), (int)round((env.MaxY - env.MinY) / m_dScale));
+	if (m_Clip.contains(frame))
+		return;
+	if (geom.Dimension == 0) {
+		if (m_nPathPoints > 0)
+			Flush(g);
+		DrawPoints(g, geom, repres);
+		return;
+	}
+	if ((frame.getWidth() < 2) && (frame.getHeight() < 2) && (geom.Dimension > 0)) {
+		g.setColour(juce::Colour(repres.PenColor));
+		g.drawRect(frame, 2);
+		return;
+	}
+	if (m_bBatch) {
+		if ((m_nPathPoints > 0) && ((geom.Fill != m_bFill) || (repres.PenColor != m_BatchRepres.PenColor) ||
+			(repres.FillColor != m_BatchRepres.FillColor) || (repres.PenSize != m_BatchRepres.PenSize)))
+			Flush(g);
+		m_BatchRepres = repres;
+		DrawGeometry(geom, repres.Decimation);
+		if (m_nPathPoints >= maxBatchPoints)
+			Flush(g);
+		return;
+	}
+	ClearPath();
+	DrawGeometry(geom, repres.Decimation);
+	StrokeAndFill(g, repres);
+	ClearPath();
+}
+
+//==============================================================================
+// Construction du path d'une geometrie a plat
+//==============================================================================
+void VectorRenderer::DrawGeometry(const FlatGeometry& geom, float tolerance)
+{
+	m_fTolerance = tolerance;
+	if (geom.Fill)
+		m_bFill = true;
+	int numPt = (int)geom.Pt.size() / 2;
+	if (!AllocPoints(numPt))
+		return;
+	ToPixel(geom.Pt.data(), numPt, m_dX0, m_dY0, m_dScale, m_Pix);
+	for (int i = 0; i < geom.NumParts(); i++) {
+		const float* pix = &m_Pix[2 * geom.PartStart(i)];
+		if (geom.Types[i] == FlatGeometry::Point) {
+			float d = 3.f;
+			m_nPathPoints += 4;
+			m_Path.startNewSubPath(pix[0], pix[1]);
+			m_Path.addEllipse(pix[0] - d, pix[1] - d, 2 * d, 2 * d);
+			continue;
+		}
+		AddPolyline(pix, geom.PartCount(i), geom.Types[i] == FlatGeometry::Ring);
+	}
+}
+
+//==============================================================================
+// Dessin des points : le symbole est rasterise une fois par style, puis copie
+// a la position de chaque point. Les symboles de 1 ou 2 pixels sont ecrits
+// directement sous forme de rectangles
+//==============================================================================
+void VectorRenderer::DrawPoints(juce::Graphics& g, const FlatGeometry& geom, const GeoBase::Repres& repres)
+{
+	int numPt = (int)geom.Pt.size() / 2;
+	if (!AllocPoints(numPt))
+		return;
+	ToPixel(geom.Pt.data(), numPt, m_dX0, m_dY0, m_dScale, m_Pix);
+	float size = repres.SymbolSize + repres.PenSize;
+	if (size <= 2.f) {
+		float d = (size <= 1.f) ? 1.f : 2.f;
+		juce::RectangleList<float> rects;
+		rects.ensureStorageAllocated(numPt);
+		for (int i = 0; i < numPt; i++)
+			rects.addWithoutMerging(juce::Rectangle<float>(floorf(m_Pix[2 * i] - 0.5f * d + 0.5f), floorf(m_Pix[2 * i + 1] - 0.5f * d + 0.5f), d, d));
+		g.setColour(juce::Colour(repres.PenColor));
+		g.fillRectList(rects);
+		return;
+	}
+	const juce::Image& sprite = Sprite(repres);
+	float c = 0.5f * sprite.getWidth();
+	g.setOpacity(1.f);
+	for (int i = 0; i < numPt; i++)
+		g.drawImageAt(sprite, (int)floorf(m_Pix[2 * i] - c + 0.5f), (int)floorf(m_Pix[2 * i + 1] - c + 0.5f));
+}
+
+//==============================================================================
+// Symbole d'un style de point, centre dans une image carree
+//==============================================================================
+const juce::Image& VectorRenderer::Sprite(const GeoBase::Repres& repres)
+{
+	std::tuple<GUInt32, float, float> key(repres.PenColor, repres.PenSize, repres.SymbolSize);
+	auto iter = m_Sprites.find(key);
+	if (iter != m_Sprites.end())
+		return iter->second;
+	int size = (int)ceil(repres.SymbolSize + repres.PenSize) + 2;
+	juce::Image sprite(juce::Image::PixelFormat::ARGB, size, size, true);
+	{
+		juce::Graphics g(sprite);
+		float c = 0.5f * size, d = 0.5f * repres.SymbolSize;
+		juce::Path path;
+		path.addEllipse(c - d, c - d, 2 * d, 2 * d);
+		g.setColour(juce::Colour(repres.PenColor));
+		g.strokePath(path, juce::PathStrokeType(repres.PenSize, juce::PathStrokeType::beveled));
+	}
+	return m_Sprites[key] = sprite;
+}
+
+//==============================================================================
+// Dessin du lot en attente : hors mode par lots, le path n'appartient pas a un lot
+//==============================================================================
+void VectorRenderer::Flush(juce::Graphics& g)
+{
+	if ((m_bBatch) && (m_nPathPoints > 0))
+		StrokeAndFill(g, m_BatchRepres);
+	ClearPath();
+}
+
+void VectorRenderer::StrokeAndFill(juce::Graphics& g, const GeoBase::Repres& repres)
+{
+	g.setColour(juce::Colour(repres.PenColor));
+	g.strokePath(m_Path, juce::PathStrokeType(repres.PenSize, juce::PathStrokeType::beveled));
+	if (m_bFill) {
+		g.setFillType(juce::FillType(juce::Colour(repres.FillColor)));
+		g.fillPath(m_Path);
+	}
+}
+
+//==============================================================================
+// Dessin des geometries OGR
+//==============================================================================
+void VectorRenderer::DrawGeometry(const OGRGeometry* poGeom, float tolerance)
+{
+	m_fTolerance = tolerance;
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbPoint)
+		return DrawPoint(poGeom);
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbPolygon)
+		DrawPolygon(poGeom);
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiPolygon)
+		DrawMultiPolygon(poGeom);
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbLineString)
+		DrawLineString(poGeom);
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiLineString)
+		DrawMultiLineString(poGeom);
+	if (wkbFlatten(poGeom->getGeometryType()) == wkbMultiPoint)
+		DrawMultiPoint(poGeom);
+}
+
+void VectorRenderer::DrawPoint(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbPoint)
+		return;
+	const OGRPoint* poPoint = poGeom->toPoint();
+	double X = (poPoint->getX() - m_dX0) / m_dScale, Y = (m_dY0 - poPoint->getY()) / m_dScale;
+	double d = 3;
+	m_nPathPoints += 4;
+	m_Path.startNewSubPath(X, Y);
+	m_Path.addEllipse(X - d, Y - d, 2 * d, 2 * d);
+}
+
+void VectorRenderer::DrawPolygon(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbPolygon)
+		return;
+	m_bFill = true;
+	const OGRPolygon* poPolygon = poGeom->toPolygon();
+	const OGRCurve* poCurve = poPolygon->getExteriorRingCurve();
+	DrawCurve(poCurve);
+	for (int i = 0; i < poPolygon->getNumInteriorRings(); i++) {
+		poCurve = poPolygon->getInteriorRingCurve(i);
+		DrawCurve(poCurve);
+	}
+}
+
+void VectorRenderer::DrawMultiPolygon(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiPolygon)
+		return;
+	m_bFill = true;
+	const OGRMultiPolygon* poMPolygon = poGeom->toMultiPolygon();
+	for (int i = 0; i < poMPolygon->getNumGeometries(); i++)
+		DrawPolygon(poMPolygon->getGeometryRef(i));
+}
+
+void VectorRenderer::DrawLineString(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbLineString)
+		return;
+	const OGRLineString* poLine = poGeom->toLineString();
+	if (!AllocPoints(poLine->getNumPoints()))
+		return;
+	poLine->getPoints(m_Pt, 2 * sizeof(double), &m_Pt[1], 2 * sizeof(double));
+	ToPixel(m_Pt, poLine->getNumPoints(), m_dX0, m_dY0, m_dScale, m_Pix);
+	AddPolyline(m_Pix, poLine->getNumPoints(), false);
+}
+
+void VectorRenderer::DrawCurve(const OGRCurve* poCurve)
+{
+	if (wkbFlatten(poCurve->getGeometryType()) == wkbLineString)
+		return DrawLineString(poCurve);
+	if (strcmp(poCurve->getGeometryName(), "LINEARRING") == 0) {
+		const OGRLinearRing* poRing = poCurve->toLinearRing();
+		return DrawLinearRing(poRing);
+	}
+}
+
+void VectorRenderer::DrawLinearRing(const OGRLinearRing* poRing)
+{
+	if (!AllocPoints(poRing->getNumPoints()))
+		return;
+	poRing->getPoints(m_Pt, 2 * sizeof(double), &m_Pt[1], 2 * sizeof(double));
+	ToPixel(m_Pt, poRing->getNumPoints(), m_dX0, m_dY0, m_dScale, m_Pix);
+	AddPolyline(m_Pix, poRing->getNumPoints(), true);
+}
+
+void VectorRenderer::DrawMultiLineString(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiLineString)
+		return;
+	const OGRMultiLineString* poMLine = poGeom->toMultiLineString();
+	for (int i = 0; i < poMLine->getNumGeometries(); i++)
+		DrawLineString(poMLine->getGeometryRef(i));
+}
+
+void VectorRenderer::DrawMultiPoint(const OGRGeometry* poGeom)
+{
+	if (wkbFlatten(poGeom->getGeometryType()) != wkbMultiPoint)
+		return;
+	const OGRMultiPoint* poMPoint = poGeom->toMultiPoint();
+	for (int i = 0; i < poMPoint->getNumGeometries(); i++)
+		DrawPoint(poMPoint->getGeometryRef(i));
+}
@@ -0,0 +1,95 @@
+//==============================================================================
+// VectorRenderer.h
+//
+// Author : F.Becirspahic
+// Date : 17/10/2026
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <JuceHeader.h>
+#include "ogrsf_frmts.h"
+#include "GeoBase.h"
+#include "GeometryCache.h"
+
+//==============================================================================
+// VectorRenderer : dessin des geometries OGR dans une image
+// Chaque thread de dessin possede son propre VectorRenderer
+//==============================================================================
+class VectorRenderer {
+public:
+  VectorRenderer();
+  virtual ~VectorRenderer();
+
+  void SetWorld(const double& X0, const double& Y0, const double& scale) { m_dX0 = X0; m_dY0 = Y0; m_dScale = scale; }
+  void SetClip(const juce::Rectangle<int>& clip) { m_Clip = clip; }
+  void SetBatch(bool batch) { m_bBatch = batch; }
+  void ResetNumObjects() { m_nNumObjects = 0; }
+  // Seuls les objets dont le coin haut gauche de l'enveloppe est dans env sont comptes (vide : tous)
+  void SetCountEnvelope(const OGREnvelope& env) { m_CountEnv = env; }
+  juce::int64 NumObjects() { return m_nNumObjects; }
+
+  // Dessin d'au plus maxFeatures features du layer : renvoie false quand le layer est termine
+  // source : OGRLayer lu a la place de celui du layer (dataset du pool), nul pour le dataset partage
+  bool DrawFeatures(GeoBase::VectorLayer* layer, juce::Graphics& g, GeoBase::Transformation* transfo, int maxFeatures,
+                    OGRLayer* source = nullptr);
+  // Dessin d'au plus maxFeatures features d'une liste, a partir de index : renvoie false quand la liste est terminee
+  bool DrawFeatures(GeoBase::VectorLayer* layer, juce::Graphics& g, GeoBase::Transformation* transfo,
+                    std::vector<GeoBase::Feature>& features, size_t& index, int maxFeatures);
+  void DrawFeatureId(GeoBase::VectorLayer* layer, juce::Graphics& g, GeoBase::Transformation* transfo, GIntBig id,
+                     OGRLayer* source = nullptr);
+  // Dessin d'un feature deja lu ; CacheFeature le projette seulement dans le cache, pour un dessin ulterieur par son identifiant
+  void DrawFeature(GeoBase::VectorLayer* layer, juce::Graphics& g, GeoBase::Transformation* transfo, OGRFeature* poFeature);
+  void CacheFeature(GeoBase::VectorLayer* layer, GeoBase::Transformation* transfo, OGRFeature* poFeature);
+  void DrawFeature(juce::Graphics& g, const FlatGeometry& geom, const GeoBase::Repres& repres);
+  // Dessin du lot de geometries en attente (mode par lots)
+  void Flush(juce::Graphics& g);
+
+  // Construction du path d'une geometrie (coordonnees pixel)
+  void ClearPath() { m_Path.clear(); m_bFill = false; m_nPathPoints = 0; }
+  void DrawGeometry(const OGRGeometry*, float tolerance = 0.f);
+  void DrawGeometry(const FlatGeometry& geom, float tolerance = 0.f);
+  const juce::Path& GetPath() { return m_Path; }
+  bool NeedFill() { return m_bFill; }
+
+  // Conversion terrain -> pixel d'un tableau de sommets (x0, y0, x1, y1 ...) en une passe (SSE2 / AVX2)
+  static void ToPixel(const double* pt, int n, const double& X0, const double& Y0, const double& scale, float* pix);
+  // Comparaison du noyau de conversion avec la boucle point par point
+  static juce::String Benchmark(int numPoints = 1000000, int numLoops = 20);
+
+private:
+  double        m_dX0, m_dY0, m_dScale; // Transformation terrain -> pixel
+  double*       m_Pt;
+  float*        m_Pix;          // Sommets en coordonnees pixel
+  int           m_nPtAlloc;
+  juce::Path    m_Path;
+  bool          m_bFill;        // Indique que le path doit etre rempli
+  bool          m_bBatch;       // Mode par lots : les features de meme style sont regroupees dans un seul path
+  int           m_nPathPoints;  // Nombre de sommets dans le path
+  GeoBase::Repres m_BatchRepres;  // Style du lot en attente
+  FlatGeometry  m_Flat;         // Geometrie courante, quand elle n'est pas dans le cache
+  float         m_fTolerance;   // Tolerance de simplification (pixels)
+  juce::int64   m_nNumObjects;  // Nombre d'objets dessines
+  OGREnvelope   m_CountEnv;     // Zone de comptage des objets (tuiles)
+  juce::Rectangle<int>  m_Clip; // Zone deja dessinee
+  std::map<std::tuple<GUInt32, float, float>, juce::Image> m_Sprites; // Symboles des points deja rasterises
+
+  bool AllocPoints(int numPt);
+  const FlatGeometry* LoadGeometry(OGRFeature* poFeature, GeoBase::Transformation* transfo, GeometryCache* cache);
+  void StrokeAndFill(juce::Graphics& g, const GeoBase::Repres& repres);
+  void AddPolyline(const float* pix, int numPt, bool closed);
+  void DrawPoints(juce::Graphics& g, const FlatGeometry& geom, const GeoBase::Repres& repres);
+  const juce::Image& Sprite(const GeoBase::Repres& repres);
+  void Count(const FlatGeometry* geom);
+
+  void DrawPoint(const OGRGeometry*);
+  void DrawPolygon(const OGRGeometry*);
+  void DrawMultiPolygon(const OGRGeometry*);
+  void DrawLineString(const OGRGeometry*);
+  void DrawMultiLineString(const OGRGeometry*);
+  void DrawMultiPoint(const OGRGeometry*);
+  void DrawCurve(const OGRCurve*);
+  void DrawLinearRing(const OGRLinearRing*);
+};